@@ -10,7 +10,12 @@
 #include "GameFramework/PlayerController.h"
 #include "GenericSingletons.h"
 #include "GenericStoragesLog.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/DateTime.h"
+#include "Misc/FileHelper.h"
 #include "Misc/MessageDialog.h"
+#include "Misc/Paths.h"
 #include "Stats/Stats2.h"
 #include "Templates/SharedPointer.h"
 #include "UObject/ObjectMacros.h"
@@ -21,9 +26,45 @@
 #include "Editor.h"
 #endif
 
+#if UE_4_26_OR_LATER
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#endif
+
 //////////////////////////////////////////////////////////////////////////
 namespace DeferredComponentRegistry
 {
+static auto PrefixName = TEXT("`");
+
+// everything needed to spawn one deferred component, resolved once per actor class and net mode
+struct FSpawnEntry
+{
+	TSubclassOf<UActorComponent> RegClass;
+	FName CompName;
+	FString TraceName;
+	bool bSetReplicated;
+	bool bSetNameStable;
+};
+using FSpawnPlan = TArray<FSpawnEntry>;
+using FSpawnPlanPtr = TSharedPtr<const FSpawnPlan>;
+
+struct FClassSpawnPlans
+{
+	FSpawnPlanPtr Plans[NM_MAX];
+	// every component class referenced by the plans above, entries hold them raw
+	TArray<TWeakObjectPtr<UClass>, TInlineAllocator<8>> RegClasses;
+	uint8 BuiltModes = 0;
+
+	bool IsStale() const
+	{
+		for (auto& RegClass : RegClasses)
+		{
+			if (!RegClass.IsValid())
+				return true;
+		}
+		return false;
+	}
+};
+
 struct ClassDataStorage : public ClassStorage::TClassStorageImpl<FRegClassDataArray>
 {
 	void AddDeferredComponents(TSubclassOf<AActor> Class, const TSet<TSubclassOf<UActorComponent>>& RegDatas, bool bPersistent, uint8 Mode)
@@ -53,10 +94,299 @@ struct ClassDataStorage : public ClassStorage::TClassStorageImpl<FRegClassDataAr
 			});
 		}
 	}
+
+	template<typename F>
+	void ModifyData(const UStruct* Class, bool bPersistent, const F& Fun)
+	{
+		TClassStorageImpl::ModifyData(Class, bPersistent, Fun);
+		// registrations on a class affect all its subclasses
+		SpawnPlans.Reset();
+	}
+
+	void Cleanup()
+	{
+		TClassStorageImpl::Cleanup();
+		SpawnPlans.Reset();
+	}
+
+	// shared so that spawning components which modify the registry or spawn other actors would not invalidate it
+	FSpawnPlanPtr GetSpawnPlan(UClass* ActorClass, ENetMode NetMode)
+	{
+		check(NetMode < NM_MAX);
+		auto Found = SpawnPlans.Find(ActorClass);
+		if (Found && Found->IsStale())
+		{
+			// a registered component class went away, rebuild this actor class only
+			SpawnPlans.Remove(ActorClass);
+			Found = nullptr;
+		}
+		if (!Found)
+		{
+			// drop plans of actor classes collected since, keys are weak so they never match again
+			for (auto It = SpawnPlans.CreateIterator(); It; ++It)
+			{
+				if (!It->Key.IsValid() || It->Value.IsStale())
+					It.RemoveCurrent();
+			}
+		}
+		auto& ClassPlans = Found ? *Found : SpawnPlans.Add(ActorClass);
+		if (ClassPlans.BuiltModes & (1 << NetMode))
+			return ClassPlans.Plans[NetMode];
+		ClassPlans.BuiltModes |= (1 << NetMode);
+
+		const bool bIsClient = (NetMode != NM_DedicatedServer);
+		const uint8 SideFlag = bIsClient ? EComponentDeferredMode::ClientSide : EComponentDeferredMode::ServerSide;
+		TSharedPtr<FSpawnPlan> Plan = MakeShared<FSpawnPlan>();
+		TArray<TSubclassOf<UActorComponent>, TInlineAllocator<8>> Visited;
+		for (auto It = CreateIterator(ActorClass); It; ++It)
+		{
+			for (auto& RegData : It->Data)
+			{
+				if (!ensure(IsValid(RegData.RegClass)))
+					continue;
+
+				// subclass registrations come first and win
+				if (Visited.Contains(RegData.RegClass))
+					continue;
+				Visited.Add(RegData.RegClass);
+
+				if ((RegData.RegFlags & SideFlag) == 0)
+					continue;
+
+				auto CDO = RegData.RegClass.GetDefaultObject();
+				const bool bIsReplicated = CDO->GetIsReplicated();
+				const bool bSetReplicated = EComponentDeferredMode::HasAnyFlags(RegData.RegFlags, EComponentDeferredMode::Replicated);
+
+				const bool bIsNameStable = CDO->IsNameStableForNetworking();
+				const bool bSetNameStable = EComponentDeferredMode::HasAnyFlags(RegData.RegFlags, EComponentDeferredMode::NameStable);
+
+				if (bIsClient)
+				{
+					if (EComponentDeferredMode::HasAnyFlags(RegData.RegFlags, EComponentDeferredMode::ServerSide) && (bIsReplicated || bSetReplicated) && !bSetNameStable && !bIsNameStable)
+					{
+						continue;
+					}
+				}
+
+				FSpawnEntry& Entry = Plan->AddDefaulted_GetRef();
+				Entry.RegClass = RegData.RegClass;
+				Entry.CompName = *FString::Printf(TEXT("%s_%s"), PrefixName, *RegData.RegClass->GetName());
+				Entry.TraceName = FString::Printf(TEXT("DeferredComponent_%s"), *RegData.RegClass->GetName());
+				Entry.bSetReplicated = bSetReplicated;
+				Entry.bSetNameStable = bSetNameStable;
+				ClassPlans.RegClasses.AddUnique(RegData.RegClass.Get());
+			}
+		}
+		if (Plan->Num())
+			ClassPlans.Plans[NetMode] = MoveTemp(Plan);
+		return ClassPlans.Plans[NetMode];
+	}
+
+protected:
+	TMap<TWeakObjectPtr<UClass>, FClassSpawnPlans> SpawnPlans;
 };
 
 ClassDataStorage Storage;
 
+// pooled components are rooted and parked in the transient package
+struct FComponentPool
+{
+	TArray<UActorComponent*> Components;
+
+	void Flush(int32 NewSize = 0)
+	{
+		while (Components.Num() > NewSize)
+		{
+			UActorComponent* Comp = Components.Pop(EAllowShrinking::No);
+			Comp->RemoveFromRoot();
+			if (IsValid(Comp))
+				Comp->DestroyComponent();
+		}
+	}
+};
+using FComponentPools = TMap<TWeakObjectPtr<UClass>, FComponentPool>;
+// max pool size per component class
+TMap<TWeakObjectPtr<UClass>, int32> PoolSizes;
+// pools are kept per world so that a component never gets recycled into another world
+TMap<TWeakObjectPtr<UWorld>, FComponentPools> WorldPools;
+
+static const ERenameFlags PoolRenameFlags = REN_DontCreateRedirectors | REN_NonTransactional | REN_DoNotDirty;
+
+UActorComponent* AcquirePooledComponent(const FSpawnEntry& Entry, AActor& Actor)
+{
+	// recycled objects would keep stale net guids
+	if (Entry.bSetReplicated)
+		return nullptr;
+
+	auto Pools = WorldPools.Find(Actor.GetWorld());
+	auto Pool = Pools ? Pools->Find(Entry.RegClass.Get()) : nullptr;
+	if (!Pool)
+		return nullptr;
+
+	while (Pool->Components.Num())
+	{
+		UActorComponent* Comp = Pool->Components.Pop(EAllowShrinking::No);
+		Comp->RemoveFromRoot();
+		if (!IsValid(Comp))
+			continue;
+
+		// PostRename moves the owned component to the new owner
+		Comp->Rename(*Entry.CompName.ToString(), &Actor, PoolRenameFlags);
+		if (auto Poolable = Cast<IDeferredComponentPoolable>(Comp))
+			Poolable->OnDeferredComponentReused(Actor);
+		return Comp;
+	}
+	return nullptr;
+}
+
+void RecycleDeferredComponents(AActor* Actor)
+{
+	if (!PoolSizes.Num() || !Actor || !Actor->GetWorld())
+		return;
+
+	FSpawnPlanPtr Plan = Storage.GetSpawnPlan(Actor->GetClass(), Actor->GetNetMode());
+	if (!Plan)
+		return;
+
+	QUICK_SCOPE_CYCLE_COUNTER(STAT_DeferredComponentRegistry_RecycleComponents);
+	UWorld* World = Actor->GetWorld();
+	for (const FSpawnEntry& Entry : *Plan)
+	{
+		auto MaxSize = Entry.bSetReplicated ? nullptr : PoolSizes.Find(Entry.RegClass.Get());
+		if (!MaxSize)
+			continue;
+		auto Pools = WorldPools.Find(World);
+		auto Pool = Pools ? Pools->Find(Entry.RegClass.Get()) : nullptr;
+		if (Pool && Pool->Components.Num() >= *MaxSize)
+			continue;
+
+		auto Comp = static_cast<UActorComponent*>(StaticFindObjectFast(Entry.RegClass, Actor, Entry.CompName));
+		if (!IsValid(Comp))
+			continue;
+
+		if (Comp->HasBegunPlay())
+			Comp->EndPlay(EEndPlayReason::Destroyed);
+		if (Comp->HasBeenInitialized())
+			Comp->UninitializeComponent();
+		if (Comp->IsActive())
+			Comp->Deactivate();
+		if (Comp->IsRegistered())
+			Comp->UnregisterComponent();
+		Actor->RemoveInstanceComponent(Comp);
+		Comp->Rename(nullptr, GetTransientPackage(), PoolRenameFlags);
+		Comp->AddToRoot();
+		if (auto Poolable = Cast<IDeferredComponentPoolable>(Comp))
+			Poolable->OnDeferredComponentRecycled();
+		// callbacks above could have recycled other actors and grown the maps
+		WorldPools.FindOrAdd(World).FindOrAdd(Entry.RegClass.Get()).Components.Add(Comp);
+	}
+}
+
+namespace SpawnStats
+{
+static bool bEnabled = false;
+static FAutoConsoleVariableRef CVarEnabled(TEXT("GenericStorages.DeferredComponentStats"), bEnabled, TEXT("collect spawn cost of deferred components per actor class and component class"));
+
+struct FStat
+{
+	int32 Count = 0;
+	int32 PooledCount = 0;
+	double TotalSeconds = 0.0;
+	double MaxSeconds = 0.0;
+	// object size of newly created components, pooled ones add nothing
+	int64 MemoryBytes = 0;
+};
+using FStatKey = TPair<FName, FName>;
+static TMap<FStatKey, FStat> Stats;
+
+void Record(const UClass* ActorClass, const UClass* CompClass, double Seconds, bool bPooled)
+{
+	FStat& Stat = Stats.FindOrAdd(FStatKey(ActorClass->GetFName(), CompClass->GetFName()));
+	++Stat.Count;
+	Stat.TotalSeconds += Seconds;
+	Stat.MaxSeconds = FMath::Max(Stat.MaxSeconds, Seconds);
+	if (bPooled)
+		++Stat.PooledCount;
+	else
+		Stat.MemoryBytes += CompClass->GetStructureSize();
+}
+
+TArray<TPair<FStatKey, FStat>> GetSorted()
+{
+	TArray<TPair<FStatKey, FStat>> Sorted = Stats.Array();
+	Sorted.Sort([](auto& Lhs, auto& Rhs) { return Lhs.Value.TotalSeconds > Rhs.Value.TotalSeconds; });
+	return Sorted;
+}
+
+void Dump(FOutputDevice& Ar)
+{
+	TMap<FName, FStat> ActorStats;
+	auto Sorted = GetSorted();
+	for (auto& Pair : Sorted)
+	{
+		FStat& ActorStat = ActorStats.FindOrAdd(Pair.Key.Key);
+		ActorStat.Count += Pair.Value.Count;
+		ActorStat.PooledCount += Pair.Value.PooledCount;
+		ActorStat.TotalSeconds += Pair.Value.TotalSeconds;
+		ActorStat.MaxSeconds = FMath::Max(ActorStat.MaxSeconds, Pair.Value.MaxSeconds);
+		ActorStat.MemoryBytes += Pair.Value.MemoryBytes;
+	}
+	ActorStats.ValueSort([](auto& Lhs, auto& Rhs) { return Lhs.TotalSeconds > Rhs.TotalSeconds; });
+
+	Ar.Logf(TEXT("DeferredComponentStats : %d actor classes, %d entries%s"), ActorStats.Num(), Sorted.Num(), bEnabled ? TEXT("") : TEXT(" (collecting disabled)"));
+	for (auto& ActorPair : ActorStats)
+	{
+		const FStat& ActorStat = ActorPair.Value;
+		Ar.Logf(TEXT("  %s : Count=%d Pooled=%d Total=%.3fms Max=%.3fms Memory=%lld"), *ActorPair.Key.ToString(), ActorStat.Count, ActorStat.PooledCount, ActorStat.TotalSeconds * 1000.0, ActorStat.MaxSeconds * 1000.0, ActorStat.MemoryBytes);
+		for (auto& Pair : Sorted)
+		{
+			if (Pair.Key.Key != ActorPair.Key)
+				continue;
+			const FStat& Stat = Pair.Value;
+			Ar.Logf(TEXT("    %s : Count=%d Pooled=%d Total=%.3fms Avg=%.3fms Max=%.3fms Memory=%lld"),
+					*Pair.Key.Value.ToString(),
+					Stat.Count,
+					Stat.PooledCount,
+					Stat.TotalSeconds * 1000.0,
+					Stat.TotalSeconds * 1000.0 / FMath::Max(Stat.Count, 1),
+					Stat.MaxSeconds * 1000.0,
+					Stat.MemoryBytes);
+		}
+	}
+}
+
+bool ExportCsv(const FString& InPath)
+{
+	FString Path = InPath;
+	if (Path.IsEmpty())
+		Path = FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("Profiling"), FString::Printf(TEXT("DeferredComponentStats-%s.csv"), *FDateTime::Now().ToString()));
+
+	FString Csv = TEXT("ActorClass,ComponentClass,Count,Pooled,TotalMs,AvgMs,MaxMs,MemoryBytes\n");
+	for (auto& Pair : GetSorted())
+	{
+		const FStat& Stat = Pair.Value;
+		Csv += FString::Printf(TEXT("%s,%s,%d,%d,%.4f,%.4f,%.4f,%lld\n"),
+							   *Pair.Key.Key.ToString(),
+							   *Pair.Key.Value.ToString(),
+							   Stat.Count,
+							   Stat.PooledCount,
+							   Stat.TotalSeconds * 1000.0,
+							   Stat.TotalSeconds * 1000.0 / FMath::Max(Stat.Count, 1),
+							   Stat.MaxSeconds * 1000.0,
+							   Stat.MemoryBytes);
+	}
+	const bool bSucc = FFileHelper::SaveStringToFile(Csv, *Path);
+	UE_LOG(LogGenericStorages, Log, TEXT("DeferredComponentStats export %s : %s"), bSucc ? TEXT("succeeded") : TEXT("failed"), *Path);
+	return bSucc;
+}
+
+static FAutoConsoleCommandWithOutputDevice DumpCmd(TEXT("GenericStorages.DumpDeferredComponentStats"), TEXT("dump deferred component spawn costs per actor class"), FConsoleCommandWithOutputDeviceDelegate::CreateStatic(&Dump));
+static FAutoConsoleCommand ExportCmd(TEXT("GenericStorages.ExportDeferredComponentStats"),
+									 TEXT("export deferred component spawn costs to csv, optional arg: file path"),
+									 FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args) { ExportCsv(Args.Num() ? Args[0] : FString()); }));
+static FAutoConsoleCommand ResetCmd(TEXT("GenericStorages.ResetDeferredComponentStats"), TEXT("reset deferred component spawn costs"), FConsoleCommandDelegate::CreateLambda([] { Stats.Reset(); }));
+}  // namespace SpawnStats
+
 void AppendDeferredComponents(AActor& Actor)
 {
 #if WITH_EDITOR
@@ -64,12 +394,10 @@ void AppendDeferredComponents(AActor& Actor)
 	if (!(World->WorldType == EWorldType::PIE || World->WorldType == EWorldType::Game))
 		return;
 #endif
-	auto CurClass = Actor.GetClass();
-	auto It = Storage.CreateIterator(CurClass);
-	if (!It)
+	FSpawnPlanPtr Plan = Storage.GetSpawnPlan(Actor.GetClass(), Actor.GetNetMode());
+	if (!Plan)
 		return;
 
-	static auto PrefixName = TEXT("`");
 #if WITH_EDITOR
 	// check names
 	TArray<FString> Names;
@@ -98,68 +426,93 @@ void AppendDeferredComponents(AActor& Actor)
 #endif
 
 	QUICK_SCOPE_CYCLE_COUNTER(STAT_DeferredComponentRegistry_AppendDeferredComponents);
-	do
+
+	struct FSpawnedComponent
 	{
-		auto& CurData = *It;
-		for (auto& RegData : CurData.Data)
+		UActorComponent* Comp;
+		const FSpawnEntry* Entry;
+		double Seconds;
+		bool bPooled;
+	};
+	const bool bCollectStats = SpawnStats::bEnabled;
+	double StartTime = 0.0;
+
+	TArray<FSpawnedComponent, TInlineAllocator<8>> Spawned;
+	{
+		QUICK_SCOPE_CYCLE_COUNTER(STAT_DeferredComponentRegistry_SpawnComponents);
+		for (const FSpawnEntry& Entry : *Plan)
 		{
-			if (!ensure(IsValid(RegData.RegClass)))
+			// check existing deferred component
+			if (!ensure(!StaticFindObjectFast(Entry.RegClass, &Actor, Entry.CompName)))
+			{
+				UE_LOG(LogGenericStorages, Warning, TEXT("DeferredComponentRegistry::AppendDeferComponents Skip ActorComponent %s For Actor %s"), *GetNameSafe(Entry.RegClass), *GetNameSafe(&Actor));
 				continue;
+			}
 
-			const bool bIsClient = (Actor.GetNetMode() != NM_DedicatedServer);
-			//
-			if ((RegData.RegFlags & (bIsClient ? EComponentDeferredMode::ClientSide : EComponentDeferredMode::ServerSide)) == 0)
-				continue;
+#ifdef TRACE_CPUPROFILER_EVENT_SCOPE_TEXT
+			TRACE_CPUPROFILER_EVENT_SCOPE_TEXT(*Entry.TraceName);
+#endif
+			if (bCollectStats)
+				StartTime = FPlatformTime::Seconds();
 
-			auto CDO = RegData.RegClass.GetDefaultObject();
-			const bool bIsReplicated = CDO->GetIsReplicated();
-			const bool bSetReplicated = EComponentDeferredMode::HasAnyFlags(RegData.RegFlags, EComponentDeferredMode::Replicated);
+			UE_LOG(LogGenericStorages, Log, TEXT("DeferredComponentRegistry::AppendDeferredComponents %s : %s"), *Actor.GetName(), *Entry.RegClass->GetName());
+			UActorComponent* ActorComp = AcquirePooledComponent(Entry, Actor);
+			const bool bPooled = !!ActorComp;
+			// no need AddOwnedComponent as NewObject does
+			if (!ActorComp)
+				ActorComp = NewObject<UActorComponent>(&Actor, Entry.RegClass, Entry.CompName, RF_Transient);
+			if (Entry.bSetNameStable)
+				ActorComp->SetNetAddressable();
+			if (Entry.bSetReplicated)
+				ActorComp->SetIsReplicated(true);
+			Spawned.Add(FSpawnedComponent{ActorComp, &Entry, bCollectStats ? FPlatformTime::Seconds() - StartTime : 0.0, bPooled});
+		}
+	}
 
-			const bool bIsNameStable = CDO->IsNameStableForNetworking();
-			const bool bSetNameStable = EComponentDeferredMode::HasAnyFlags(RegData.RegFlags, EComponentDeferredMode::NameStable);
+	// register after all components are created so they could see each other
+	for (FSpawnedComponent& Item : Spawned)
+	{
+#ifdef TRACE_CPUPROFILER_EVENT_SCOPE_TEXT
+		TRACE_CPUPROFILER_EVENT_SCOPE_TEXT(*Item.Entry->TraceName);
+#endif
+		if (bCollectStats)
+			StartTime = FPlatformTime::Seconds();
+		Item.Comp->RegisterComponent();
+		if (bCollectStats)
+			Item.Seconds += FPlatformTime::Seconds() - StartTime;
+	}
 
-			if (bIsClient)
-			{
-				if (EComponentDeferredMode::HasAnyFlags(RegData.RegFlags, EComponentDeferredMode::ServerSide) && (bIsReplicated || bSetReplicated) && !bSetNameStable && !bIsNameStable)
-				{
-					continue;
-				}
-			}
+	if (TOnComponentInitialized<AActor>::bNeedInit)
+	{
+		for (FSpawnedComponent& Item : Spawned)
+		{
+#ifdef TRACE_CPUPROFILER_EVENT_SCOPE_TEXT
+			TRACE_CPUPROFILER_EVENT_SCOPE_TEXT(*Item.Entry->TraceName);
+#endif
+			if (bCollectStats)
+				StartTime = FPlatformTime::Seconds();
 
-			// check existing deferred component
-			if (!ensure(!Actor.FindComponentByClass(CurClass)))
+			UActorComponent* ActorComp = Item.Comp;
+			Actor.AddInstanceComponent(ActorComp);
+
+			if (ActorComp->bAutoActivate && !ActorComp->IsActive())
 			{
-				UE_LOG(LogGenericStorages, Warning, TEXT("DeferredComponentRegistry::AppendDeferComponents Skip ActorComponent %s For Actor %s"), *GetNameSafe(RegData.RegClass), *GetNameSafe(&Actor));
+				ActorComp->Activate(true);
 			}
-			else
+			if (ActorComp->bWantsInitializeComponent && !ActorComp->HasBeenInitialized())
 			{
-				UE_LOG(LogGenericStorages, Log, TEXT("DeferredComponentRegistry::AppendDeferredComponents %s : %s"), *Actor.GetName(), *RegData.RegClass->GetName());
-				QUICK_SCOPE_CYCLE_COUNTER(STAT_DeferredComponentRegistry_SpawnComponents);
-				FName CompName = *FString::Printf(TEXT("%s_%s"), PrefixName, *RegData.RegClass->GetName());
-				// no need AddOwnedComponent as NewObject does
-				UActorComponent* ActorComp = NewObject<UActorComponent>(&Actor, RegData.RegClass, *CompName.ToString(), RF_Transient);
-				if (bSetNameStable)
-					ActorComp->SetNetAddressable();
-				if (bSetReplicated)
-					ActorComp->SetIsReplicated(true);
-				ActorComp->RegisterComponent();
-
-				if (TOnComponentInitialized<AActor>::bNeedInit)
-				{
-					Actor.AddInstanceComponent(ActorComp);
-
-					if (ActorComp->bAutoActivate && !ActorComp->IsActive())
-					{
-						ActorComp->Activate(true);
-					}
-					if (ActorComp->bWantsInitializeComponent && !ActorComp->HasBeenInitialized())
-					{
-						ActorComp->InitializeComponent();
-					}
-				}
+				ActorComp->InitializeComponent();
 			}
+			if (bCollectStats)
+				Item.Seconds += FPlatformTime::Seconds() - StartTime;
 		}
-	} while (++It);
+	}
+
+	if (bCollectStats)
+	{
+		for (const FSpawnedComponent& Item : Spawned)
+			SpawnStats::Record(Actor.GetClass(), Item.Entry->RegClass, Item.Seconds, Item.bPooled);
+	}
 }
 
 static FDelayedAutoRegisterHelper DelayInnerInitUDeferredComponentRegistry(EDelayedRegisterRunPhase::EndOfEngineInit, [] {
@@ -177,6 +530,22 @@ static FDelayedAutoRegisterHelper DelayInnerInitUDeferredComponentRegistry(EDela
 		// FWorldDelegates::OnPreWorldFinishDestroy.AddLambda([](UWorld*) { Storage.Cleanup(); });
 	}
 
+	// pooling
+#if UE_5_00_OR_LATER
+	FWorldDelegates::OnPostWorldInitialization.AddLambda([](UWorld* World, const UWorld::InitializationValues IVS) {
+		if (World && World->IsGameWorld())
+			World->AddOnActorDestroyedHandler(FOnActorDestroyed::FDelegate::CreateStatic(&RecycleDeferredComponents));
+	});
+#endif
+	FWorldDelegates::OnWorldCleanup.AddLambda([](UWorld* World, bool bSessionEnded, bool bCleanupResources) {
+		FComponentPools Pools;
+		if (WorldPools.RemoveAndCopyValue(World, Pools))
+		{
+			for (auto& Pair : Pools)
+				Pair.Value.Flush();
+		}
+	});
+
 	// Bind
 	TOnComponentInitialized<AActor>::Bind();
 });
@@ -204,6 +573,44 @@ void UDeferredComponentRegistry::EnableAdd(bool bNewEnabled)
 	DeferredComponentRegistry::Storage.SetEnableState(bNewEnabled);
 }
 
+void UDeferredComponentRegistry::SetDeferredComponentPooled(TSubclassOf<UActorComponent> ComponentClass, int32 MaxPoolSize)
+{
+	if (!ensureAlways(ComponentClass))
+		return;
+
+	using namespace DeferredComponentRegistry;
+	if (MaxPoolSize <= 0)
+	{
+		PoolSizes.Remove(ComponentClass.Get());
+		for (auto& WorldPair : WorldPools)
+		{
+			if (auto Pool = WorldPair.Value.Find(ComponentClass.Get()))
+			{
+				Pool->Flush();
+				WorldPair.Value.Remove(ComponentClass.Get());
+			}
+		}
+		return;
+	}
+
+	// recycled objects would keep stale net guids
+	if (ComponentClass.GetDefaultObject()->GetIsReplicated())
+	{
+		UE_LOG(LogGenericStorages, Warning, TEXT("DeferredComponentRegistry::SetDeferredComponentPooled replicated component %s cannot be pooled"), *ComponentClass->GetName());
+		return;
+	}
+#if !UE_5_00_OR_LATER
+	UE_LOG(LogGenericStorages, Warning, TEXT("DeferredComponentRegistry::SetDeferredComponentPooled %s : components are only recycled on UE5"), *ComponentClass->GetName());
+#endif
+
+	PoolSizes.Add(ComponentClass.Get(), MaxPoolSize);
+	for (auto& WorldPair : WorldPools)
+	{
+		if (auto Pool = WorldPair.Value.Find(ComponentClass.Get()))
+			Pool->Flush(MaxPoolSize);
+	}
+}
+
 uint8 UDeferredComponentRegistry::GetMode(uint8 InFlags, TSubclassOf<UActorComponent> InClass)
 {
 	auto TmpFlags = InFlags;
@@ -3,6 +3,7 @@
 #include "GenericSingletons.h"
 
 #include "ClassDataStorage.h"
+#include "Containers/Ticker.h"
 #include "Engine/AssetManager.h"
 #include "Engine/Engine.h"
 #include "Engine/GameEngine.h"
@@ -12,12 +13,16 @@
 #include "Engine/World.h"
 #include "GenericStoragesLog.h"
 #include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
 #include "Misc/PackageName.h"
+#include "Misc/ScopeRWLock.h"
 #include "Runtime/Launch/Resources/Version.h"
 #include "TimerManager.h"
+#include "UObject/ObjectKey.h"
 #include "UObject/UObjectGlobals.h"
 #include "UObject/UObjectThreadContext.h"
 #include "WorldLocalStorages.h"
+#include <atomic>
 
 #if !UE_SERVER
 #include "Blueprint/UserWidget.h"
@@ -468,9 +473,8 @@ private:
 };
 #endif
 
-UObject* DynamicReflectionImpl(const FString& TypeName, UClass* TypeClass)
+static UObject* DynamicReflectionSlow(const FString& TypeName, UClass* TypeClass, bool& bOutViaRedirector)
 {
-	TypeClass = TypeClass ? TypeClass : UObject::StaticClass();
 	bool bIsValidName = true;
 	FString FailureReason;
 	UObject* ClassPackage = nullptr;
@@ -534,6 +538,7 @@ UObject* DynamicReflectionImpl(const FString& TypeName, UClass* TypeClass)
 			if (UObjectRedirector* RenamedClassRedirector = FindObject<UObjectRedirector>(ANY_PACKAGE_COMPATIABLE, *ObjectName))
 			{
 				NewReflection = RenamedClassRedirector->DestinationObject;
+				bOutViaRedirector = !!NewReflection;
 			}
 		}
 
@@ -544,60 +549,257 @@ UObject* DynamicReflectionImpl(const FString& TypeName, UClass* TypeClass)
 	return NewReflection;
 }
 
-void DeferredWorldCleanup(FSimpleDelegate Cb, FString Desc, bool EditorOnly)
+namespace ReflectionCache
 {
-	if (!EditorOnly || GIsEditor)
+	struct FCacheKey
 	{
-#if WITH_EDITOR
-		FGameDelegates::Get().GetEndPlayMapDelegate().Add(Cb);
+		FName Name;
+		const UClass* TypeClass;
+		friend bool operator==(const FCacheKey& Lhs, const FCacheKey& Rhs) { return Lhs.Name == Rhs.Name && Lhs.TypeClass == Rhs.TypeClass; }
+		friend uint32 GetTypeHash(const FCacheKey& Key) { return HashCombine(GetTypeHash(Key.Name), PointerHash(Key.TypeClass)); }
+	};
+	struct FCacheValue
+	{
+		TWeakObjectPtr<UObject> Object;
+		bool bViaRedirector = false;
+	};
+
+	static FRWLock Lock;
+	static TMap<FCacheKey, FCacheValue> Entries;
+	static std::atomic<uint64> Hits{0};
+	static std::atomic<uint64> Misses{0};
+
+	static void Reset()
+	{
+		FRWScopeLock ScopeLock(Lock, SLT_Write);
+		Entries.Reset();
+	}
+
+	// drop stale objects and everything resolved through a redirector, as redirector fixups replace them
+	static void Compact()
+	{
+		FRWScopeLock ScopeLock(Lock, SLT_Write);
+		for (auto It = Entries.CreateIterator(); It; ++It)
+		{
+			if (It->Value.bViaRedirector || !It->Value.Object.IsValid())
+				It.RemoveCurrent();
+		}
+	}
+
+	// bound once on the game thread, not by whichever thread misses first
+	static FDelayedAutoRegisterHelper DelayBindInvalidation(EDelayedRegisterRunPhase::ObjectSystemReady, [] {
+		FCoreUObjectDelegates::GetPostGarbageCollect().AddStatic(&Compact);
+		FCoreUObjectDelegates::OnPackageReloaded.AddStatic([](EPackageReloadPhase, FPackageReloadedEvent*) { Reset(); });
+#if UE_5_00_OR_LATER
+		FCoreUObjectDelegates::ReloadCompleteDelegate.AddStatic([](EReloadCompleteReason) { Reset(); });
 #endif
+	});
+
+	// lookups only find existing names so misses never grow the name table, names are added on insert
+	static FCacheKey MakeKey(const FString& TypeName, UClass* TypeClass, EFindName FindType = FNAME_Find)
+	{
+		// FName comparison is case insensitive, which matches StaticFindObject
+		return FCacheKey{FName(*TypeName.TrimStartAndEnd(), FindType), TypeClass};
+	}
+
+	static UObject* Find(const FCacheKey& Key)
+	{
+		if (Key.Name.IsNone())
+			return nullptr;
+		FRWScopeLock ScopeLock(Lock, SLT_ReadOnly);
+		auto Found = Entries.Find(Key);
+		return Found ? Found->Object.Get() : nullptr;
+	}
+}  // namespace ReflectionCache
+
+UObject* DynamicReflectionImpl(const FString& TypeName, UClass* TypeClass)
+{
+	TypeClass = TypeClass ? TypeClass : UObject::StaticClass();
+	if (UObject* Cached = ReflectionCache::Find(ReflectionCache::MakeKey(TypeName, TypeClass)))
+	{
+		++ReflectionCache::Hits;
+		return Cached;
+	}
+
+	++ReflectionCache::Misses;
+	bool bViaRedirector = false;
+	UObject* NewReflection = DynamicReflectionSlow(TypeName, TypeClass, bViaRedirector);
+	// misses are not cached, the type may be loaded later on
+	if (NewReflection && !IsReloadActive())
+	{
+		auto Key = ReflectionCache::MakeKey(TypeName, TypeClass, FNAME_Add);
+		FRWScopeLock ScopeLock(ReflectionCache::Lock, SLT_Write);
+		ReflectionCache::Entries.Add(Key, {NewReflection, bViaRedirector});
+	}
+	return NewReflection;
+}
+
+int32 DynamicReflectionBatchImpl(TArrayView<const FString> TypeNames, UClass* TypeClass, TArray<UObject*>& OutResults)
+{
+	TypeClass = TypeClass ? TypeClass : UObject::StaticClass();
+	OutResults.Reset(TypeNames.Num());
+	OutResults.AddZeroed(TypeNames.Num());
 
-		struct FDeferredWorldCleanup
+	int32 NumResolved = 0;
+	TArray<int32, TInlineAllocator<16>> Pendings;
+	{
+		FRWScopeLock ScopeLock(ReflectionCache::Lock, SLT_ReadOnly);
+		for (int32 i = 0; i < TypeNames.Num(); ++i)
 		{
-			FSimpleDelegate Cb;
-			FString Desc;
-			FDeferredWorldCleanup(FSimpleDelegate&& InCb, FString&& InDesc)
-				: Cb(MoveTemp(InCb))
-				, Desc(MoveTemp(InDesc))
-			{
-			}
+			auto Key = ReflectionCache::MakeKey(TypeNames[i], TypeClass);
+			auto Found = Key.Name.IsNone() ? nullptr : ReflectionCache::Entries.Find(Key);
+			OutResults[i] = Found ? Found->Object.Get() : nullptr;
+			if (OutResults[i])
+				++NumResolved;
+			else
+				Pendings.Add(i);
+		}
+	}
+	ReflectionCache::Hits += NumResolved;
+
+	for (auto Idx : Pendings)
+	{
+		OutResults[Idx] = DynamicReflectionImpl(TypeNames[Idx], TypeClass);
+		if (OutResults[Idx])
+			++NumResolved;
+	}
+	return NumResolved;
+}
 
-			void operator()(const bool) const { Execute(); }
-			void operator()(const FString&) const { Execute(); }
-			void Execute() const
+void GetDynamicReflectionStats(uint64& OutHits, uint64& OutMisses)
+{
+	OutHits = ReflectionCache::Hits;
+	OutMisses = ReflectionCache::Misses;
+}
+
+void ResetDynamicReflectionCache()
+{
+	ReflectionCache::Reset();
+}
+
+static FAutoConsoleCommand DumpDynamicReflectionCmd(TEXT("GenericStorages.DynamicReflectionStats"), TEXT("dump DynamicReflection cache statistics"), FConsoleCommandDelegate::CreateLambda([] {
+	uint64 CacheHits = 0;
+	uint64 CacheMisses = 0;
+	GetDynamicReflectionStats(CacheHits, CacheMisses);
+	int32 NumEntries = 0;
+	{
+		FRWScopeLock ScopeLock(ReflectionCache::Lock, SLT_ReadOnly);
+		NumEntries = ReflectionCache::Entries.Num();
+	}
+	UE_LOG(LogGenericStorages, Display, TEXT("DynamicReflection Entries:%d Hits:%llu Misses:%llu"), NumEntries, CacheHits, CacheMisses);
+}));
+
+namespace WorldCleanups
+{
+	struct FCleanupEntry
+	{
+		FString Desc;
+		// handlers are keyed by Desc and the object they are bound to
+		FObjectKey Owner;
+		uint32 Id = 0;
+		FSimpleDelegate Cb;
+		double LastTime = 0.0;
+		double TotalTime = 0.0;
+		int32 NumCalls = 0;
+	};
+	// registration order is execution order
+	static TArray<FCleanupEntry> Entries;
+	static uint32 NextId = 0;
+
+	static FCleanupEntry* FindById(uint32 Id) { return Entries.FindByPredicate([&](const FCleanupEntry& Cell) { return Cell.Id == Id; }); }
+
+	static void ExecuteAll(const TCHAR* Reason)
+	{
+		check(IsInGameThread());
+		if (!Entries.Num())
+			return;
+
+		QUICK_SCOPE_CYCLE_COUNTER(STAT_GenericStorages_DeferredWorldCleanup);
+		// handlers may register or unregister others during the pass, only those registered when the pass starts and still registered run
+		TArray<uint32, TInlineAllocator<64>> Snapshot;
+		for (auto& Entry : Entries)
+			Snapshot.Add(Entry.Id);
+		const double StartTime = FPlatformTime::Seconds();
+		for (uint32 Id : Snapshot)
+		{
+			auto Entry = FindById(Id);
+			if (!Entry || !Entry->Cb.IsBound())
+				continue;
+
+			// the entry may be replaced or removed by the handler itself
+			FSimpleDelegate Cb = Entry->Cb;
+			const FString Desc = Entry->Desc;
+			const double HandlerStart = FPlatformTime::Seconds();
+			Cb.Execute();
+			const double Elapsed = FPlatformTime::Seconds() - HandlerStart;
+			UE_LOG(LogGenericStorages, Log, TEXT("DeferredWorldCleanup %s %.3fms"), *Desc, Elapsed * 1000.0);
+
+			if (auto Found = FindById(Id))
 			{
-				UE_LOG(LogGenericStorages, Log, TEXT("DeferredWorldCleanup %s"), *Desc);
-				Cb.ExecuteIfBound();
+				Found->LastTime = Elapsed;
+				Found->TotalTime += Elapsed;
+				++Found->NumCalls;
 			}
-		} DeferredAction(MoveTemp(Cb), MoveTemp(Desc));
+		}
+		// weak bound handlers whose owner is gone will never run again
+		Entries.RemoveAll([](const FCleanupEntry& Cell) { return !Cell.Cb.IsBound(); });
+		UE_LOG(LogGenericStorages, Log, TEXT("DeferredWorldCleanup %s : %d handlers %.3fms"), Reason, Snapshot.Num(), (FPlatformTime::Seconds() - StartTime) * 1000.0);
+	}
+
+	static void BindWorldTransitions()
+	{
+		if (!TrueOnFirstCall([] {}))
+			return;
 
 #if WITH_EDITOR
+		FGameDelegates::Get().GetEndPlayMapDelegate().AddStatic([] { ExecuteAll(TEXT("EndPlayMap")); });
 		if (GIsEditor)
 		{
-			if (auto Obj = Cb.GetUObject())
-			{
-				FEditorDelegates::PreBeginPIE.Add(CreateWeakLambda<FEditorDelegates::FOnPIEEvent::FDelegate>(Obj, MoveTemp(DeferredAction)));
-			}
-			else
-			{
-				FEditorDelegates::PreBeginPIE.AddLambda(MoveTemp(DeferredAction));
-			}
+			FEditorDelegates::PreBeginPIE.AddStatic([](const bool) { ExecuteAll(TEXT("PreBeginPIE")); });
 		}
 #endif
+		// Register for PreloadMap, so cleanup can occur on map transitions
+		FCoreUObjectDelegates::PreLoadMap.AddStatic([](const FString&) { ExecuteAll(TEXT("PreLoadMap")); });
+	}
+
+	static FAutoConsoleCommand DumpWorldCleanupsCmd(TEXT("GenericStorages.DumpWorldCleanups"), TEXT("dump DeferredWorldCleanup handlers and their timings"), FConsoleCommandDelegate::CreateLambda([] {
+		for (auto& Entry : Entries)
 		{
-			// Register for PreloadMap, so cleanup can occur on map transitions
-			if (auto Obj = Cb.GetUObject())
-			{
-				FCoreUObjectDelegates::PreLoadMap.Add(CreateWeakLambda<FCoreUObjectDelegates::FPreLoadMapDelegate::FDelegate>(Obj, MoveTemp(DeferredAction)));
-			}
-			else
-			{
-				// cleanup
-				FCoreUObjectDelegates::PreLoadMap.AddLambda(MoveTemp(DeferredAction));
-			}
+			UE_LOG(LogGenericStorages, Display, TEXT("DeferredWorldCleanup %s Calls:%d Last:%.3fms Total:%.3fms"), *Entry.Desc, Entry.NumCalls, Entry.LastTime * 1000.0, Entry.TotalTime * 1000.0);
+		}
+	}));
+}  // namespace WorldCleanups
+
+void DeferredWorldCleanup(FSimpleDelegate Cb, FString Desc, bool EditorOnly)
+{
+	if (!EditorOnly || GIsEditor)
+	{
+		check(IsInGameThread());
+		WorldCleanups::BindWorldTransitions();
+
+		// same Desc and owner replaces the previous handler in place instead of piling up
+		const FObjectKey Owner(Cb.GetUObject());
+		if (auto Found = WorldCleanups::Entries.FindByPredicate([&](const WorldCleanups::FCleanupEntry& Cell) { return Cell.Desc == Desc && Cell.Owner == Owner; }))
+		{
+			Found->Cb = MoveTemp(Cb);
+		}
+		else
+		{
+			auto& Entry = WorldCleanups::Entries.AddDefaulted_GetRef();
+			Entry.Desc = MoveTemp(Desc);
+			Entry.Owner = Owner;
+			Entry.Id = ++WorldCleanups::NextId;
+			Entry.Cb = MoveTemp(Cb);
 		}
 	}
 }
+
+bool UnregisterDeferredWorldCleanup(const FString& Desc, const UObject* InObj)
+{
+	check(IsInGameThread());
+	const FObjectKey Owner(InObj);
+	return WorldCleanups::Entries.RemoveAll([&](const WorldCleanups::FCleanupEntry& Cell) { return Cell.Desc == Desc && (!InObj || Cell.Owner == Owner); }) > 0;
+}
 }  // namespace GenericSingletons
 
 #if USE_GENEIRC_SINGLETON_GUARD
@@ -974,3 +1176,123 @@ bool UGenericSingletons::AsyncCreate(const FSoftClassPath& SoftPath, FAsyncLoadO
 	WorldContextObj = WorldContextObj ? WorldContextObj : Cb.GetUObject();
 	return AsyncLoadCls(SoftPath, WorldContextObj, [WorldContextObj, Cb{MoveTemp(Cb)}](UClass* ResolvedCls) { Cb.ExecuteIfBound(CreateInstanceImpl(WorldContextObj, ResolvedCls)); }).IsValid();
 }
+
+namespace GenericStorages
+{
+#if UE_5_00_OR_LATER
+using FGSTicker = FTSTicker;
+#else
+using FGSTicker = FTicker;
+#endif
+
+// 'SingletonDependsOn' lists class names (comma separated) which should be created before this one
+// metadata is stripped in cooked builds, where the caller's order is kept and dependencies are still created lazily on access
+static void SortSingletonsByDependencies(TArray<UClass*>& InOutClasses)
+{
+#if WITH_METADATA
+	static const FName NAME_SingletonDependsOn = TEXT("SingletonDependsOn");
+	TMap<FName, UClass*> NameLookups;
+	for (auto Cls : InOutClasses)
+		NameLookups.Add(Cls->GetFName(), Cls);
+
+	TArray<UClass*> Sorted;
+	Sorted.Reserve(InOutClasses.Num());
+	TMap<UClass*, bool> Visited;  // false : visiting, true : done
+	TFunction<void(UClass*)> Visit = [&](UClass* Cls) {
+		if (bool* Done = Visited.Find(Cls))
+		{
+			UE_CLOG(!*Done, LogGenericStorages, Warning, TEXT("PrewarmSingletons circular dependency detected at %s"), *Cls->GetName());
+			return;
+		}
+		Visited.Add(Cls, false);
+		for (auto CurCls = Cls; CurCls && CurCls != UObject::StaticClass(); CurCls = CurCls->GetSuperClass())
+		{
+			if (!CurCls->HasMetaData(NAME_SingletonDependsOn))
+				continue;
+
+			TArray<FString> DepNames;
+			CurCls->GetMetaData(NAME_SingletonDependsOn).ParseIntoArray(DepNames, TEXT(","), true);
+			for (auto& DepName : DepNames)
+			{
+				if (UClass** Dep = NameLookups.Find(*DepName.TrimStartAndEnd()))
+					Visit(*Dep);
+			}
+		}
+		Visited.Add(Cls, true);
+		Sorted.Add(Cls);
+	};
+	for (auto Cls : InOutClasses)
+		Visit(Cls);
+	InOutClasses = MoveTemp(Sorted);
+#endif
+}
+
+struct FSingletonPrewarmTask
+{
+	TArray<TWeakObjectPtr<UClass>> Classes;
+	TArray<UObject*> Created;
+	TWeakObjectPtr<const UObject> WeakCtx;
+	FAsyncBatchObjCallback OnCompleted;
+	double FrameBudget = 0.0;
+	int32 Cursor = 0;
+	bool bHasCtx = false;
+
+	bool Tick(float)
+	{
+		const UObject* Ctx = WeakCtx.Get();
+		if (bHasCtx && !Ctx)
+		{
+			UE_LOG(LogGenericStorages, Warning, TEXT("PrewarmSingletons aborted : context destroyed with %d singletons pending"), Classes.Num() - Cursor);
+			return false;
+		}
+
+		if (IsGarbageCollecting())
+			return true;
+
+		const double StartTime = FPlatformTime::Seconds();
+		do
+		{
+			if (UClass* Cls = Classes[Cursor].Get())
+			{
+				if (auto Ptr = UGenericSingletons::GetSingletonImpl(Cls, Ctx))
+					Created.Add(Ptr);
+			}
+		} while (++Cursor < Classes.Num() && (FPlatformTime::Seconds() - StartTime) < FrameBudget);
+
+		if (Cursor < Classes.Num())
+			return true;
+
+		UE_LOG(LogGenericStorages, Log, TEXT("PrewarmSingletons completed : %d/%d created"), Created.Num(), Classes.Num());
+		OnCompleted.ExecuteIfBound(Created);
+		return false;
+	}
+};
+}  // namespace GenericStorages
+
+TSharedPtr<struct FStreamableHandle> UGenericSingletons::PrewarmSingletons(const TArray<FSoftClassPath>& InPaths, const UObject* Ctx, FAsyncBatchObjCallback OnCompleted, float FrameBudgetMs, TAsyncLoadPriority Priority)
+{
+	check(IsInGameThread());
+	auto Task = MakeShared<GenericStorages::FSingletonPrewarmTask>();
+	Task->WeakCtx = Ctx;
+	Task->bHasCtx = !!Ctx;
+	Task->OnCompleted = MoveTemp(OnCompleted);
+	Task->FrameBudget = FMath::Max(FrameBudgetMs, 0.f) / 1000.0;
+
+	return AsyncLoadCls(InPaths, FAsyncBatchClsCallback::CreateLambda([Task](TArray<UClass*>& Loaded) {
+							GenericStorages::SortSingletonsByDependencies(Loaded);
+							Task->Classes.Reserve(Loaded.Num());
+							for (auto Cls : Loaded)
+								Task->Classes.Add(Cls);
+
+							if (Task->Classes.Num() == 0)
+							{
+								Task->OnCompleted.ExecuteIfBound(Task->Created);
+								return;
+							}
+							// create the first batch right away, spread the rest over the following frames
+							if (Task->Tick(0.f))
+								GenericStorages::FGSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda([Task](float DeltaTime) { return Task->Tick(DeltaTime); }));
+						}),
+						true,
+						Priority);
+}
@@ -21,6 +21,7 @@
 #include "Engine/World.h"
 #include "GenericSingletons.h"
 #include "GenericStoragesLog.h"
+#include "HAL/PlatformTime.h"
 #include "Misc/CoreDelegates.h"
 #include "Misc/DelayedAutoRegister.h"
 #include "Modules/ModuleInterface.h"
@@ -70,10 +71,142 @@ static FDelayedAutoRegisterHelper DelayOnEngineInitCompleted(EDelayedRegisterRun
 	OnFEngineLoopInitCompleted.Clear();
 });
 
+namespace NextTick
+{
+	struct FItem
+	{
+		FTimerDelegate Delegate;
+		bool bEnsureExec;
+	};
+	struct FLane
+	{
+		TArray<FItem> Items;
+		int32 Head = 0;
+	};
+	struct FWorldQueue
+	{
+		FLane Lanes[(uint8)EDelayExecLane::Num];
+		double Budget = 0.0;
+		bool bDispatching = false;
+	};
+	static TMap<TWeakObjectPtr<UWorld>, FWorldQueue> Queues;
+
+	static void Dispatch(UWorld* World, ELevelTick, float)
+	{
+		FWorldQueue* Queue = Queues.Find(World);
+		if (!Queue || Queue->bDispatching)
+			return;
+
+		QUICK_SCOPE_CYCLE_COUNTER(STAT_GenericStorages_NextTickDispatch);
+		Queue->bDispatching = true;
+		const double StartTime = FPlatformTime::Seconds();
+		const double Budget = Queue->Budget;
+		int32 NumExecuted = 0;
+		bool bOverBudget = false;
+
+		// callbacks queued during this dispatch wait for the next frame, whichever lane they go to
+		int32 Counts[(uint8)EDelayExecLane::Num];
+		for (uint8 LaneIdx = 0; LaneIdx < (uint8)EDelayExecLane::Num; ++LaneIdx)
+			Counts[LaneIdx] = Queue->Lanes[LaneIdx].Items.Num();
+
+		for (uint8 LaneIdx = 0; LaneIdx < (uint8)EDelayExecLane::Num && !bOverBudget; ++LaneIdx)
+		{
+			const int32 Count = Counts[LaneIdx];
+			while (Queue->Lanes[LaneIdx].Head < Count)
+			{
+				// always make progress, then honor the budget
+				if (NumExecuted > 0 && Budget > 0.0 && (FPlatformTime::Seconds() - StartTime) >= Budget)
+				{
+					bOverBudget = true;
+					break;
+				}
+
+				// the callback may reenter and grow the queue, so never hold references across it
+				FTimerDelegate Cb = MoveTemp(Queue->Lanes[LaneIdx].Items[Queue->Lanes[LaneIdx].Head++].Delegate);
+				Cb.ExecuteIfBound();
+				++NumExecuted;
+
+				Queue = Queues.Find(World);
+				if (!Queue)
+					return;
+			}
+
+			FLane& Lane = Queue->Lanes[LaneIdx];
+			if (Lane.Head == Lane.Items.Num())
+			{
+				Lane.Items.Reset();
+			}
+			else if (Lane.Head > 0)
+			{
+				Lane.Items.RemoveAt(0, Lane.Head, EAllowShrinking::No);
+			}
+			Lane.Head = 0;
+		}
+		UE_CLOG(bOverBudget, LogGenericStorages, Verbose, TEXT("NextTick budget exhausted for %s after %d callbacks"), *GetNameSafe(World), NumExecuted);
+		Queue->bDispatching = false;
+	}
+
+	static FWorldQueue& FindOrAddQueue(UWorld* World)
+	{
+		check(IsInGameThread());
+		if (TrueOnFirstCall([] {}))
+		{
+			FWorldDelegates::OnWorldPostActorTick.AddStatic(&Dispatch);
+			// pending callbacks die with the world as the world timers do, except those which must run
+			FWorldDelegates::OnWorldCleanup.AddStatic([](UWorld* InWorld, bool, bool) {
+				FWorldQueue Removed;
+				if (!Queues.RemoveAndCopyValue(InWorld, Removed))
+					return;
+				for (FLane& Lane : Removed.Lanes)
+				{
+					for (int32 Idx = Lane.Head; Idx < Lane.Items.Num(); ++Idx)
+					{
+						if (Lane.Items[Idx].bEnsureExec)
+							Lane.Items[Idx].Delegate.ExecuteIfBound();
+					}
+				}
+			});
+		}
+		return Queues.FindOrAdd(World);
+	}
+
+	// both entry points fall back to GWorld and only queue for game worlds
+	static bool TryEnqueue(const UObject* InObj, FTimerDelegate& Delegate, EDelayExecLane Lane, bool bEnsureExec)
+	{
+		auto World = GEngine->GetWorldFromContextObject(InObj, InObj ? EGetWorldErrorMode::LogAndReturnNull : EGetWorldErrorMode::ReturnNull);
+		World = World ? World : (UWorld*)GWorld;
+		if (!World || !World->IsGameWorld())
+			return false;
+
+		FindOrAddQueue(World).Lanes[(uint8)Lane].Items.Add(FItem{MoveTemp(Delegate), bEnsureExec});
+		return true;
+	}
+}  // namespace NextTick
+
+bool CallOnWorldNextTickImpl(const UObject* InObj, FTimerDelegate Delegate, EDelayExecLane Lane, bool bEnsureExec)
+{
+	if (!ensure(Lane < EDelayExecLane::Num))
+		Lane = EDelayExecLane::Normal;
+	if (NextTick::TryEnqueue(InObj, Delegate, Lane, bEnsureExec))
+		return true;
+	return DelayExec(InObj, MoveTemp(Delegate), 0.f, bEnsureExec);
+}
+
+void SetNextTickBudget(const UObject* InObj, float BudgetMs)
+{
+	auto World = GEngine->GetWorldFromContextObject(InObj, EGetWorldErrorMode::LogAndReturnNull);
+	if (World && World->IsGameWorld())
+		NextTick::FindOrAddQueue(World).Budget = FMath::Max(BudgetMs, 0.f) / 1000.0;
+}
+
 bool DelayExec(const UObject* InObj, FTimerDelegate Delegate, float InDelay, bool bEnsureExec)
 {
-	InDelay = FMath::Max(InDelay, 0.00001f);
+	if (InDelay <= 0.f && NextTick::TryEnqueue(InObj, Delegate, EDelayExecLane::Normal, bEnsureExec))
+		return true;
+
 	auto World = GEngine->GetWorldFromContextObject(InObj, InObj ? EGetWorldErrorMode::LogAndReturnNull : EGetWorldErrorMode::ReturnNull);
+
+	InDelay = FMath::Max(InDelay, 0.00001f);
 #if WITH_EDITOR
 	if (bEnsureExec && (!World || !World->IsGameWorld()))
 	{
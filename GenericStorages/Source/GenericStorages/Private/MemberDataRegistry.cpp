@@ -1,10 +1,16 @@
 ﻿// Copyright GenericStorages, Inc. All Rights Reserved.
 
 #include "MemberDataRegistry.h"
+
+#include "Engine/World.h"
+#include "MemberDataRegistryPrivate.h"
+#include "Misc/DelayedAutoRegister.h"
+#include "Misc/ScopeLock.h"
+#include "UObject/UObjectArray.h"
+#include "UnrealCompatibility.h"
 #if WITH_EDITOR
 #include "Engine/Engine.h"
 #include "Engine/GameEngine.h"
-#include "Engine/World.h"
 #include "GenericSingletons.h"
 #include "UObject/UObjectThreadContext.h"
 #endif
@@ -18,3 +24,177 @@ FWeakMemberDataTag::FWeakMemberDataTag()
 		Outer = Initializer;
 #endif
 }
+
+namespace MemberDataRegistry
+{
+// one table per world, created by its subsystem or by the first owner registered before it
+// tables are heap allocated so handed out pointers stay put until the world is cleaned up
+static TMap<TWeakObjectPtr<const UWorld>, TUniquePtr<FMemberDataTable>> WorldTables;
+// owners without world
+static FMemberDataTable GlobalTable;
+static TMap<FName, int32> SlotIds;
+
+template<typename F>
+void ForEachTable(const F& Fn)
+{
+	for (auto& Pair : WorldTables)
+		Fn(*Pair.Value);
+	Fn(GlobalTable);
+}
+
+static FMemberDataTable& FindOrAddWorldTable(const UWorld* World)
+{
+	check(IsInGameThread() && World);
+	auto& Table = WorldTables.FindOrAdd(World);
+	if (!Table)
+	{
+		Table = MakeUnique<FMemberDataTable>();
+		Table->Slots.SetNum(SlotIds.Num());
+	}
+	return *Table;
+}
+
+// worlds without subsystem (inactive or editor preview worlds) would leak their table otherwise
+static FDelayedAutoRegisterHelper DelayBindWorldCleanup(EDelayedRegisterRunPhase::ObjectSystemReady, [] {
+	FWorldDelegates::OnWorldCleanup.AddStatic([](UWorld* World, bool, bool) { WorldTables.Remove(World); });
+});
+
+// clears the slots of destroyed owners so lookups never hand out dangling members
+struct FOwnerListener : public FUObjectArray::FUObjectDeleteListener
+{
+	// deletions may be notified on the gc thread, slots are only cleared on the game thread
+	FCriticalSection Lock;
+	TBitArray<> Owners;
+	bool bOwnerDeleted = false;
+	bool bListened = false;
+
+	virtual ~FOwnerListener()
+	{
+		if (bListened && UObjectInitialized())
+			GUObjectArray.RemoveUObjectDeleteListener(this);
+	}
+	virtual void NotifyUObjectDeleted(const UObjectBase* ObjectBase, int32 Index) override
+	{
+		FScopeLock ScopeLock(&Lock);
+		if (Index < Owners.Num() && Owners[Index])
+		{
+			Owners[Index] = false;
+			bOwnerDeleted = true;
+		}
+	}
+	virtual void OnUObjectArrayShutdown() override
+	{
+		if (bListened)
+		{
+			bListened = false;
+			GUObjectArray.RemoveUObjectDeleteListener(this);
+		}
+	}
+	void Watch(int32 Index)
+	{
+		check(IsInGameThread());
+		if (!bListened)
+		{
+			if (!Owners.Num())
+			{
+				Owners.Init(false, GUObjectArray.GetObjectArrayCapacity());
+				// owners are flagged unreachable before their deletion, which may happen later on another thread
+				FCoreUObjectDelegates::PostReachabilityAnalysis.AddRaw(this, &FOwnerListener::ClearStaleSlots, true);
+				FCoreUObjectDelegates::GetPostGarbageCollect().AddRaw(this, &FOwnerListener::ClearStaleSlots, false);
+#if UE_5_01_OR_LATER
+				FCoreUObjectDelegates::GetPostPurgeGarbageDelegate().AddRaw(this, &FOwnerListener::ClearStaleSlots, false);
+#endif
+			}
+			bListened = true;
+			GUObjectArray.AddUObjectDeleteListener(this);
+		}
+		FScopeLock ScopeLock(&Lock);
+		Owners[Index] = true;
+	}
+
+	static bool IsOwnerAlive(const FMemberDataSlot& Slot)
+	{
+		auto Item = GUObjectArray.IndexToObject(Slot.OwnerIndex);
+		return Item && Item->Object && Item->GetSerialNumber() == Slot.OwnerSerial && !Item->IsUnreachable();
+	}
+	void ClearStaleSlots(bool bForce)
+	{
+		check(IsInGameThread());
+		{
+			FScopeLock ScopeLock(&Lock);
+			if (!bOwnerDeleted && !bForce)
+				return;
+			bOwnerDeleted = false;
+		}
+		ForEachTable([](FMemberDataTable& Table) {
+			for (FMemberDataSlot& Slot : Table.Slots)
+			{
+				if (Slot.OwnerIndex != INDEX_NONE && !IsOwnerAlive(Slot))
+				{
+					Slot.Ptr = nullptr;
+					Slot.OwnerIndex = INDEX_NONE;
+				}
+			}
+		});
+	}
+};
+static FOwnerListener OwnerListener;
+
+int32 AllocateSlot(const char* TypeName)
+{
+	const FName Key(TypeName);
+	if (auto Find = SlotIds.Find(Key))
+		return *Find;
+	return SlotIds.Add(Key, SlotIds.Num());
+}
+
+FMemberDataTable* FindTable(const UObject* WorldContextObj)
+{
+	const UWorld* World = (WorldContextObj && WorldContextObj->IsValidLowLevelFast()) ? WorldContextObj->GetWorld() : nullptr;
+	if (!World)
+		return &GlobalTable;
+	auto Find = WorldTables.Find(World);
+	return Find ? Find->Get() : nullptr;
+}
+
+FMemberDataTable& GetTable(const UObject* WorldContextObj)
+{
+	const UWorld* World = (WorldContextObj && WorldContextObj->IsValidLowLevelFast()) ? WorldContextObj->GetWorld() : nullptr;
+	return World ? FindOrAddWorldTable(World) : GlobalTable;
+}
+
+bool RegisterData(UObject* Owner, int32 SlotId, void* Ptr, FStructProperty* Prop)
+{
+	check(IsInGameThread());
+	const UWorld* World = Owner->GetWorld();
+	FMemberDataTable* Table = World ? &FindOrAddWorldTable(World) : &GlobalTable;
+
+	auto& Slots = Table->Slots;
+	if (SlotId >= Slots.Num())
+		Slots.SetNum(SlotIds.Num());
+	FMemberDataSlot& Slot = Slots[SlotId];
+	Slot.Ptr = Ptr;
+	Slot.OwnerIndex = GUObjectArray.ObjectToIndex(Owner);
+	Slot.OwnerSerial = GUObjectArray.AllocateSerialNumber(Slot.OwnerIndex);
+#if WITH_EDITOR
+	Slot.Owner = Owner;
+	Slot.Prop = Prop;
+	ensure(!Prop || Prop->ContainerPtrToValuePtr<void>(Owner) == Ptr);
+#endif
+	OwnerListener.Watch(Slot.OwnerIndex);
+	return true;
+}
+}  // namespace MemberDataRegistry
+
+void UMemberDataSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+	Table = &MemberDataRegistry::FindOrAddWorldTable(GetWorld());
+}
+
+void UMemberDataSubsystem::Deinitialize()
+{
+	MemberDataRegistry::WorldTables.Remove(GetWorld());
+	Table = nullptr;
+	Super::Deinitialize();
+}
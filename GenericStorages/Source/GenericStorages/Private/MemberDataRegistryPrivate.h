@@ -0,0 +1,22 @@
+// Copyright GenericStorages, Inc. All Rights Reserved.
+
+#pragma once
+#include "CoreMinimal.h"
+#include "MemberDataRegistry.h"
+#include "Subsystems/WorldSubsystem.h"
+
+#include "MemberDataRegistryPrivate.generated.h"
+
+UCLASS()
+class UMemberDataSubsystem final : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	// owned by the registry, valid between Initialize and Deinitialize
+	MemberDataRegistry::FMemberDataTable* Table = nullptr;
+
+protected:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+};
@@ -2,71 +2,283 @@
 
 #include "ObjectDataRegistry.h"
 
+#include "Async/ParallelFor.h"
 #include "GameFramework/Actor.h"
 #include "GenericSingletons.h"
+#include "GenericStoragesLog.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
 #include "Misc/CoreDelegates.h"
+#include "Misc/ScopeLock.h"
 #include "PrivateFieldAccessor.h"
+#include "Stats/Stats2.h"
 #include "Templates/SharedPointer.h"
 #include "UnrealCompatibility.h"
 #include "WorldLocalStorages.h"
 
 namespace ObjectDataRegistry
 {
-using DataType = TSharedPtr<void>;
 using KeyType = FName;
 
+struct FDataType
+{
+	KeyType Key;
+	FDataTypeOps Ops;
+	// native script structs from blueprint are destroyed through reflection
+	const UScriptStruct* Struct;
+
+	void Destroy(void* Ptr) const
+	{
+		if (Struct)
+			Struct->DestroyStruct(Ptr);
+		else if (Ops.Destruct)
+			Ops.Destruct(Ptr);
+	}
+};
+
+// slot ids are handed out densely, typed slots register during static initialization so it does not depend on UObject
+struct FTypeRegistry
+{
+	TArray<FDataType> Types;
+	TMap<KeyType, int32> TypeIds;
+
+	int32 Find(const KeyType& Key) const
+	{
+		auto Find = TypeIds.Find(Key);
+		return Find ? *Find : INDEX_NONE;
+	}
+	int32 FindOrAdd(const KeyType& Key, const FDataTypeOps& Ops, const UScriptStruct* Struct = nullptr);
+};
+FTypeRegistry& GetTypeRegistry()
+{
+	static FTypeRegistry Registry;
+	return Registry;
+}
+
+int32 FTypeRegistry::FindOrAdd(const KeyType& Key, const FDataTypeOps& Ops, const UScriptStruct* Struct)
+{
+	if (auto Find = TypeIds.Find(Key))
+		return *Find;
+	const int32 TypeId = Types.Add(FDataType{Key, Ops, Struct});
+	TypeIds.Add(Key, TypeId);
+	return TypeId;
+}
+
+struct FObjectId
+{
+	int32 Index;
+	int32 SerialNumber;
+};
+
+// values of one type packed in fixed size chunks, elements never move so data pointers stay valid
+struct FTypePool
+{
+	static constexpr int32 ChunkBits = 6;
+	static constexpr int32 ChunkSize = 1 << ChunkBits;
+	static constexpr int32 ChunkMask = ChunkSize - 1;
+
+	struct FChunk
+	{
+		uint8* Data;
+		// INDEX_NONE for free elements
+		FObjectId Owners[ChunkSize];
+	};
+
+	int32 Stride;
+	int32 Alignment;
+	int32 Num = 0;
+	TArray<FChunk*> Chunks;
+	TArray<int32> FreeList;
+
+	FTypePool(const FDataTypeOps& Ops)
+		: Stride(Align(Ops.Size, Ops.Alignment))
+		, Alignment(Ops.Alignment)
+	{
+	}
+	~FTypePool()
+	{
+		for (FChunk* Chunk : Chunks)
+		{
+			FMemory::Free(Chunk->Data);
+			delete Chunk;
+		}
+	}
+
+	FORCEINLINE void* GetPtr(int32 Element) const { return Chunks[Element >> ChunkBits]->Data + (Element & ChunkMask) * Stride; }
+	FORCEINLINE FObjectId& GetOwner(int32 Element) const { return Chunks[Element >> ChunkBits]->Owners[Element & ChunkMask]; }
+
+	// the element stays unowned until it is constructed
+	int32 Allocate()
+	{
+		if (!FreeList.Num())
+		{
+			FChunk* Chunk = new FChunk;
+			Chunk->Data = (uint8*)FMemory::Malloc(Stride * ChunkSize, Alignment);
+			const int32 Base = Chunks.Add(Chunk) << ChunkBits;
+			for (int32 Idx = ChunkMask; Idx >= 0; --Idx)
+			{
+				Chunk->Owners[Idx] = FObjectId{INDEX_NONE, 0};
+				FreeList.Add(Base + Idx);
+			}
+		}
+		++Num;
+		return FreeList.Pop(EAllowShrinking::No);
+	}
+	void Free(int32 Element)
+	{
+		GetOwner(Element).Index = INDEX_NONE;
+		FreeList.Add(Element);
+		--Num;
+	}
+};
+
+// per-object sidecar, pool elements are indexed by slot id
+struct FObjectSidecar
+{
+	int32 SerialNumber;
+	int32 NumValues = 0;
+	TArray<int32, TInlineAllocator<2>> Values;
+};
+
+// sidecars directly addressed by object index, paged to keep it sparse
+struct FSidecarPages
+{
+	static constexpr int32 PageBits = 12;
+	static constexpr int32 PageMask = (1 << PageBits) - 1;
+
+	TArray<TArray<FObjectSidecar*>> Pages;
+	int32 Num = 0;
+
+	FORCEINLINE FObjectSidecar* Get(int32 Index) const
+	{
+		const int32 PageIdx = Index >> PageBits;
+		return (Pages.IsValidIndex(PageIdx) && Pages[PageIdx].Num()) ? Pages[PageIdx].GetData()[Index & PageMask] : nullptr;
+	}
+	FObjectSidecar*& GetRef(int32 Index)
+	{
+		const int32 PageIdx = Index >> PageBits;
+		if (PageIdx >= Pages.Num())
+			Pages.SetNum(PageIdx + 1);
+		if (!Pages[PageIdx].Num())
+			Pages[PageIdx].SetNumZeroed(1 << PageBits);
+		return Pages[PageIdx][Index & PageMask];
+	}
+
+	template<typename F>
+	void ForEach(const F& Fn) const
+	{
+		for (int32 PageIdx = 0; PageIdx < Pages.Num(); ++PageIdx)
+		{
+			for (int32 Idx = 0; Idx < Pages[PageIdx].Num(); ++Idx)
+			{
+				if (FObjectSidecar* Sidecar = Pages[PageIdx][Idx])
+					Fn((PageIdx << PageBits) | Idx, *Sidecar);
+			}
+		}
+	}
+};
+
 struct FObjectDataStorage : public FUObjectArray::FUObjectDeleteListener
 {
 	virtual ~FObjectDataStorage()
 	{
 		if (bListened && UObjectInitialized())
 			DisableListener();
+		for (int32 TypeId = 0; TypeId < Pools.Num(); ++TypeId)
+		{
+			if (FTypePool* Pool = Pools[TypeId].Get())
+			{
+				for (int32 Element = 0; Element < Pool->Chunks.Num() * FTypePool::ChunkSize; ++Element)
+				{
+					if (Pool->GetOwner(Element).Index != INDEX_NONE)
+						GetTypeRegistry().Types[TypeId].Destroy(Pool->GetPtr(Element));
+				}
+			}
+		}
+		Sidecars.ForEach([&](int32 Index, FObjectSidecar& Sidecar) { delete &Sidecar; });
 	}
 
-	TMap<FWeakObjectPtr, TMap<KeyType, DataType>> ObjectDataStorage;
-	TMap<KeyType, TArray<FWeakObjectPtr>> KeyCache;
+	FSidecarPages Sidecars;
+	// contiguous values per type, also serves as the reverse index of objects having each type
+	TArray<TUniquePtr<FTypePool>> Pools;
 	bool bListened = false;
 
+	// objects which may have data, preallocated to the object array capacity so deleters never see it reallocate
+	TBitArray<> ObjectsWithData;
+	// deletions are collected without allocations then purged in one pass on the game thread
+	static constexpr int32 PendingCapacity = 16 * 1024;
+	FCriticalSection PendingLock;
+	TArray<FObjectId> PendingDeletes;
+	TArray<FObjectId> PurgingDeletes;
+	bool bPendingOverflow = false;
+	double LastPurgeSeconds = 0.0;
+
 	virtual void NotifyUObjectDeleted(const UObjectBase* ObjectBase, int32 Index) override
 	{
-		auto Object = static_cast<const UObject*>(ObjectBase);
-		OnObjectRemoved(Object);
+		// may run on the gc thread
+		if (Index < ObjectsWithData.Num() && ObjectsWithData[Index])
+		{
+			const FObjectId Id{Index, GUObjectArray.IndexToObject(Index)->GetSerialNumber()};
+			FScopeLock Lock(&PendingLock);
+			if (PendingDeletes.Num() < PendingCapacity)
+				PendingDeletes.Add(Id);
+			else
+				bPendingOverflow = true;
+		}
 	}
 
-	void OnObjectRemoved(const UObject* Object)
+	void PurgePendingDeletes()
 	{
-#if UE_4_23_OR_LATER
-		// TODO IsInGarbageCollectorThread()
-		static TLockFreePointerListUnordered<FWeakObjectPtr, PLATFORM_CACHE_LINE_SIZE> GameThreadObjects;
-		if (IsInGameThread())
-#else
 		check(IsInGameThread());
-#endif
+		bool bOverflow = false;
 		{
-#if UE_4_23_OR_LATER
-			if (!GameThreadObjects.IsEmpty())
-			{
-				TArray<FWeakObjectPtr*> Objs;
-				GameThreadObjects.PopAll(Objs);
-				for (auto Ptr : Objs)
-				{
-					RemoveObject(*Ptr);
-					delete Ptr;
-				}
-			}
-#endif
-			RemoveObject(Object);
+			FScopeLock Lock(&PendingLock);
+			if (!PendingDeletes.Num() && !bPendingOverflow)
+				return;
+			// both buffers keep their capacity, no allocation
+			Swap(PendingDeletes, PurgingDeletes);
+			bOverflow = bPendingOverflow;
+			bPendingOverflow = false;
+		}
 
-			if (ObjectDataStorage.Num() == 0)
-				DisableListener();
+		QUICK_SCOPE_CYCLE_COUNTER(STAT_ObjectDataRegistry_PurgeDeletes);
+		const double StartTime = FPlatformTime::Seconds();
+		const int32 NumPurging = PurgingDeletes.Num();
+		for (const FObjectId& Id : PurgingDeletes)
+		{
+			if (!RemoveObject(Id))
+				ObjectsWithData[Id.Index] = false;
 		}
-#if UE_4_23_OR_LATER
-		else
+		PurgingDeletes.Reset();
+
+		if (bOverflow)
 		{
-			GameThreadObjects.Push(new FWeakObjectPtr(Object));
+			// lost some notifications, validate everything against the object array
+			TArray<FObjectId> Stales;
+			Sidecars.ForEach([&](int32 Index, FObjectSidecar& Sidecar) {
+				auto Item = GUObjectArray.IndexToObject(Index);
+				if (!Item || !Item->Object || Item->GetSerialNumber() != Sidecar.SerialNumber)
+					Stales.Add(FObjectId{Index, Sidecar.SerialNumber});
+			});
+			for (const FObjectId& Id : Stales)
+				RemoveObject(Id);
 		}
-#endif
+
+		if (!Sidecars.Num)
+			DisableListener();
+
+		LastPurgeSeconds = FPlatformTime::Seconds() - StartTime;
+		UE_LOG(LogGenericStorages, Verbose, TEXT("ObjectDataRegistry purged %d objects%s in %.3fms"), NumPurging, bOverflow ? TEXT(" with full scan") : TEXT(""), LastPurgeSeconds * 1000.0);
+	}
+
+	void Dump(FOutputDevice& Ar)
+	{
+		int32 NumTypes = 0;
+		for (auto& Pool : Pools)
+			NumTypes += Pool ? 1 : 0;
+		Ar.Logf(TEXT("ObjectDataRegistry : %d objects, %d types, last purge %.3fms"), Sidecars.Num, NumTypes, LastPurgeSeconds * 1000.0);
 	}
+
 	void OnUObjectArrayShutdown() { DisableListener(); }
 	void DisableListener()
 	{
@@ -80,73 +292,211 @@ struct FObjectDataStorage : public FUObjectArray::FUObjectDeleteListener
 	{
 		if (!bListened)
 		{
+			if (!ObjectsWithData.Num())
+			{
+				ObjectsWithData.Init(false, GUObjectArray.GetObjectArrayCapacity());
+				PendingDeletes.Reserve(PendingCapacity);
+				PurgingDeletes.Reserve(PendingCapacity);
+			}
 			bListened = true;
 			GUObjectArray.AddUObjectDeleteListener(this);
 		}
 	}
-	bool RemoveObject(const FWeakObjectPtr& Object)
+
+	FTypePool& GetPool(int32 TypeId)
 	{
-		if (auto Find = ObjectDataStorage.Find(Object))
-		{
-			for (auto& a : *Find)
-				KeyCache.Remove(a.Key);
-			ObjectDataStorage.Remove(Object);
+		if (TypeId >= Pools.Num())
+			Pools.SetNum(GetTypeRegistry().Types.Num());
+		if (!Pools[TypeId])
+			Pools[TypeId] = MakeUnique<FTypePool>(GetTypeRegistry().Types[TypeId].Ops);
+		return *Pools[TypeId];
+	}
+	void RemoveValue(FObjectSidecar& Sidecar, int32 TypeId)
+	{
+		// detach before destroying, destructors may touch the registry
+		const int32 Element = Sidecar.Values[TypeId];
+		Sidecar.Values[TypeId] = INDEX_NONE;
+		--Sidecar.NumValues;
+
+		FTypePool& Pool = *Pools[TypeId];
+		GetTypeRegistry().Types[TypeId].Destroy(Pool.GetPtr(Element));
+		Pool.Free(Element);
+	}
+	void RemoveSidecar(int32 Index)
+	{
+		FObjectSidecar*& Ref = Sidecars.GetRef(Index);
+		delete Ref;
+		Ref = nullptr;
+		--Sidecars.Num;
+	}
+
+	static FObjectId GetObjectId(const UObject* Object)
+	{
+		const int32 Index = GUObjectArray.ObjectToIndex(Object);
+		return FObjectId{Index, GUObjectArray.IndexToObject(Index)->GetSerialNumber()};
+	}
+
+	// returns true if the index still holds data of a newer object
+	bool RemoveObject(const FObjectId& Object)
+	{
+		FObjectSidecar* Sidecar = Sidecars.Get(Object.Index);
+		if (!Sidecar)
+			return false;
+		if (Sidecar->SerialNumber != Object.SerialNumber)
 			return true;
+
+		for (int32 TypeId = 0; TypeId < Sidecar->Values.Num(); ++TypeId)
+		{
+			if (Sidecar->Values[TypeId] != INDEX_NONE)
+				RemoveValue(*Sidecar, TypeId);
 		}
+		// destructors may have added data again
+		if (!Sidecar->NumValues)
+			RemoveSidecar(Object.Index);
 		return false;
 	}
 	bool RemoveKey(const KeyType& Key)
 	{
-		if (auto Find = KeyCache.Find(Key))
+		const int32 TypeId = GetTypeRegistry().Find(Key);
+		if (!Pools.IsValidIndex(TypeId) || !Pools[TypeId])
+			return false;
+
+		bool bRemoved = false;
+		FTypePool& Pool = *Pools[TypeId];
+		for (int32 Element = 0; Element < Pool.Chunks.Num() * FTypePool::ChunkSize; ++Element)
 		{
-			for (auto& Obj : *Find)
-			{
-				if (auto Found = ObjectDataStorage.Find(Obj))
-					Found->Remove(Key);
-			}
-			KeyCache.Remove(Key);
-			return true;
+			const FObjectId Owner = Pool.GetOwner(Element);
+			if (Owner.Index == INDEX_NONE)
+				continue;
+			FObjectSidecar* Sidecar = Sidecars.Get(Owner.Index);
+			RemoveValue(*Sidecar, TypeId);
+			if (!Sidecar->NumValues)
+				RemoveSidecar(Owner.Index);
+			bRemoved = true;
 		}
-		return false;
+		return bRemoved;
 	}
 
 public:
-	void AddObjectData(const FWeakObjectPtr& Object, const KeyType& Key, DataType Data)
+	// the data must not exist yet
+	void* AddObjectData(const UObject* Object, int32 TypeId, const TFunctionRef<void(void*)>& Construct)
 	{
-		check(Object.IsValid() && Key.IsValid());
-		if (ObjectDataStorage.Num() == 0)
+		check(IsValid(Object) && GetTypeRegistry().Types.IsValidIndex(TypeId));
+		const int32 Index = GUObjectArray.ObjectToIndex(Object);
+
+		if (!Sidecars.Num)
 			EnableListener();
-		ObjectDataStorage.FindOrAdd(Object).Add(Key, Data);
-		KeyCache.FindOrAdd(Key).Add(Object);
+
+		// stale data of a destroyed object whose deletion has not been processed yet
+		// off the game thread the serial number check below still catches it
+		if (IsInGameThread())
+			PurgePendingDeletes();
+		const int32 SerialNumber = GUObjectArray.AllocateSerialNumber(Index);
+		if (FObjectSidecar* Stale = Sidecars.Get(Index))
+		{
+			if (Stale->SerialNumber != SerialNumber)
+				RemoveObject(FObjectId{Index, Stale->SerialNumber});
+		}
+
+		// constructors may add data too, elements are stable and only owned once constructed
+		FTypePool& Pool = GetPool(TypeId);
+		const int32 Element = Pool.Allocate();
+		void* Ptr = Pool.GetPtr(Element);
+		Construct(Ptr);
+		Pool.GetOwner(Element) = FObjectId{Index, SerialNumber};
+
+		FObjectSidecar* Sidecar = Sidecars.Get(Index);
+		if (!Sidecar)
+		{
+			Sidecar = new FObjectSidecar{SerialNumber};
+			Sidecars.GetRef(Index) = Sidecar;
+			++Sidecars.Num;
+		}
+		ObjectsWithData[Index] = true;
+
+		while (Sidecar->Values.Num() <= TypeId)
+			Sidecar->Values.Add(INDEX_NONE);
+		check(Sidecar->Values[TypeId] == INDEX_NONE);
+		Sidecar->Values[TypeId] = Element;
+		++Sidecar->NumValues;
+		return Ptr;
+	}
+
+	FORCEINLINE void* GetObjectData(const UObject* Object, int32 TypeId)
+	{
+		if (TypeId == INDEX_NONE || !Object)
+			return nullptr;
+		const FObjectId Id = GetObjectId(Object);
+		FObjectSidecar* Sidecar = Sidecars.Get(Id.Index);
+		if (!Sidecar || Sidecar->SerialNumber != Id.SerialNumber || !Sidecar->Values.IsValidIndex(TypeId))
+			return nullptr;
+		const int32 Element = Sidecar->Values[TypeId];
+		return Element != INDEX_NONE ? Pools[TypeId]->GetPtr(Element) : nullptr;
+	}
+	bool RemoveObjectData(const UObject* Object, int32 TypeId)
+	{
+		check(IsValid(Object));
+		if (TypeId == INDEX_NONE)
+			return false;
+
+		const FObjectId Id = GetObjectId(Object);
+		FObjectSidecar* Sidecar = Sidecars.Get(Id.Index);
+		if (!Sidecar || Sidecar->SerialNumber != Id.SerialNumber || !Sidecar->Values.IsValidIndex(TypeId) || Sidecar->Values[TypeId] == INDEX_NONE)
+			return false;
+
+		RemoveValue(*Sidecar, TypeId);
+		if (!Sidecar->NumValues)
+			RemoveSidecar(Id.Index);
+		if (!Sidecars.Num)
+			DisableListener();
+		return true;
 	}
 
-	void* GetObjectData(const FWeakObjectPtr& Object, const KeyType& Key)
+	// walks the pool of a type chunk by chunk, objects destroyed but not purged yet are skipped
+	FORCEINLINE static UObject* ResolveOwner(const FObjectId& Owner)
+	{
+		if (Owner.Index == INDEX_NONE)
+			return nullptr;
+		auto Item = GUObjectArray.IndexToObject(Owner.Index);
+		return (Item && Item->Object && Item->GetSerialNumber() == Owner.SerialNumber && !Item->IsUnreachable()) ? static_cast<UObject*>(Item->Object) : nullptr;
+	}
+	void ForEachObjectData(int32 TypeId, const TFunctionRef<void(UObject*, void*)>& Fn)
 	{
-		if (auto Find = ObjectDataStorage.Find(Object))
+		check(IsInGameThread());
+		PurgePendingDeletes();
+		if (!Pools.IsValidIndex(TypeId) || !Pools[TypeId])
+			return;
+
+		// the callback may add data, chunks never move but the chunk array may grow
+		FTypePool& Pool = *Pools[TypeId];
+		const int32 NumChunks = Pool.Chunks.Num();
+		for (int32 ChunkIdx = 0; ChunkIdx < NumChunks; ++ChunkIdx)
 		{
-			if (auto Found = Find->Find(Key))
+			const FTypePool::FChunk* Chunk = Pool.Chunks[ChunkIdx];
+			for (int32 Idx = 0; Idx < FTypePool::ChunkSize; ++Idx)
 			{
-				return Found->Get();
+				if (UObject* Obj = ResolveOwner(Chunk->Owners[Idx]))
+					Fn(Obj, Chunk->Data + Idx * Pool.Stride);
 			}
 		}
-		return nullptr;
 	}
-	bool RemoveObjectData(const FWeakObjectPtr& Object, const KeyType& Key)
+	void ParallelForEachObjectData(int32 TypeId, const TFunctionRef<void(UObject*, void*)>& Fn)
 	{
-		check(Object.IsValid() && Key.IsValid());
-		if (auto Find = ObjectDataStorage.Find(Object))
-		{
-			if (auto Found = Find->Find(Key))
+		check(IsInGameThread());
+		PurgePendingDeletes();
+		if (!Pools.IsValidIndex(TypeId) || !Pools[TypeId])
+			return;
+
+		// one task per chunk, the registry must not be modified until it returns
+		const FTypePool& Pool = *Pools[TypeId];
+		ParallelFor(Pool.Chunks.Num(), [&](int32 ChunkIdx) {
+			const FTypePool::FChunk* Chunk = Pool.Chunks[ChunkIdx];
+			for (int32 Idx = 0; Idx < FTypePool::ChunkSize; ++Idx)
 			{
-				Find->Remove(Key);
-				if (auto Cache = KeyCache.Find(Key))
-					Cache->Remove(Object);
-				if (ObjectDataStorage.Num() == 0)
-					DisableListener();
-				return true;
+				if (UObject* Obj = ResolveOwner(Chunk->Owners[Idx]))
+					Fn(Obj, Chunk->Data + Idx * Pool.Stride);
 			}
-		}
-		return false;
+		});
 	}
 };
 
@@ -157,6 +507,17 @@ TUniquePtr<FObjectDataStorage>& GetStorage(bool bCreate = false)
 	if (bCreate && !GlobalMgr)
 	{
 		GlobalMgr = MakeUnique<FObjectDataStorage>();
+		FCoreUObjectDelegates::GetPostGarbageCollect().AddLambda([] {
+			if (GlobalMgr)
+				GlobalMgr->PurgePendingDeletes();
+		});
+#if UE_5_01_OR_LATER
+		// incremental purge deletes objects after post gc
+		FCoreUObjectDelegates::GetPostPurgeGarbageDelegate().AddLambda([] {
+			if (GlobalMgr)
+				GlobalMgr->PurgePendingDeletes();
+		});
+#endif
 		FCoreDelegates::OnPreExit.AddLambda([] {
 			if (ensureAlways(GlobalMgr))
 			{
@@ -166,32 +527,65 @@ TUniquePtr<FObjectDataStorage>& GetStorage(bool bCreate = false)
 	}
 	return GlobalMgr;
 }
+
+static FAutoConsoleCommandWithOutputDevice DumpObjectDataRegistryCmd(TEXT("GenericStorages.DumpObjectDataRegistry"), TEXT("dump object data registry sizes and last purge cost"), FConsoleCommandWithOutputDeviceDelegate::CreateLambda([](FOutputDevice& Ar) {
+	if (auto& Mgr = GetStorage())
+		Mgr->Dump(Ar);
+	else
+		Ar.Logf(TEXT("ObjectDataRegistry : not created"));
+}));
 }  // namespace ObjectDataRegistry
 
-void* FObjectDataRegistry::FindDataPtr(const UObject* Obj, FName Key)
+int32 ObjectDataRegistry::RegisterDataType(FName Key, const FDataTypeOps& Ops)
+{
+	return GetTypeRegistry().FindOrAdd(Key, Ops);
+}
+
+void* FObjectDataRegistry::FindSlotPtr(const UObject* Obj, int32 SlotId)
 {
 	if (auto& Mgr = ObjectDataRegistry::GetStorage())
 	{
-		return Mgr->GetObjectData(Obj, Key);
+		return Mgr->GetObjectData(Obj, SlotId);
 	}
 	return nullptr;
 }
 
-bool FObjectDataRegistry::DelDataPtr(const UObject* Obj, FName Key)
+bool FObjectDataRegistry::DelSlotPtr(const UObject* Obj, int32 SlotId)
 {
 	if (auto& Mgr = ObjectDataRegistry::GetStorage())
 	{
-		return Mgr->RemoveObjectData(Obj, Key);
+		return Mgr->RemoveObjectData(Obj, SlotId);
 	}
 	return false;
 }
 
+void FObjectDataRegistry::ForEachSlot(int32 SlotId, const TFunctionRef<void(UObject*, void*)>& Fn, bool bParallel)
+{
+	if (auto& Mgr = ObjectDataRegistry::GetStorage())
+	{
+		if (bParallel)
+			Mgr->ParallelForEachObjectData(SlotId, Fn);
+		else
+			Mgr->ForEachObjectData(SlotId, Fn);
+	}
+}
+
+void* FObjectDataRegistry::FindDataPtr(const UObject* Obj, FName Key)
+{
+	return FindSlotPtr(Obj, ObjectDataRegistry::GetTypeRegistry().Find(Key));
+}
+
+bool FObjectDataRegistry::DelDataPtr(const UObject* Obj, FName Key)
+{
+	return DelSlotPtr(Obj, ObjectDataRegistry::GetTypeRegistry().Find(Key));
+}
+
 //////////////////////////////////////////////////////////////////////////
 
 void UObjectDataRegistryHelper::OnActorDestroyed(AActor* InActor)
 {
 	if (auto& Mgr = ObjectDataRegistry::GetStorage())
-		Mgr->RemoveObject(FWeakObjectPtr(InActor));
+		Mgr->RemoveObject(ObjectDataRegistry::FObjectDataStorage::GetObjectId(InActor));
 }
 
 DEFINE_FUNCTION(UObjectDataRegistryHelper::execGetObjectData)
@@ -204,7 +598,8 @@ DEFINE_FUNCTION(UObjectDataRegistryHelper::execGetObjectData)
 	if (auto Prop = CastField<FStructProperty>(Stack.MostRecentProperty))
 	{
 		auto& Mgr = ObjectDataRegistry::GetStorage(true);
-		void* Ptr = Mgr->GetObjectData(Obj, Prop->Struct->GetFName());
+		auto Struct = Prop->Struct;
+		void* Ptr = Mgr->GetObjectData(Obj, ObjectDataRegistry::GetTypeRegistry().Find(Struct->GetFName()));
 		if (Ptr)
 		{
 			if (!bWriteData)
@@ -213,17 +608,12 @@ DEFINE_FUNCTION(UObjectDataRegistryHelper::execGetObjectData)
 				Prop->CopyCompleteValueFromScriptVM(Ptr, Stack.MostRecentPropertyAddress);
 			bSucc = true;
 		}
-		else if (auto Ops = Prop->Struct->GetCppStructOps())
+		else if (IsValid(Obj) && Struct->GetCppStructOps())
 		{
-			Ptr = FMemory::Malloc(Ops->GetSize(), Ops->GetAlignment());
-			Ops->Construct(Ptr);
-			auto SPtr = TSharedPtr<void>(Ptr, [Ops](void* p) {
-				if (Ops->HasDestructor())
-					Ops->Destruct(p);
-				FMemory::Free(p);
-			});
+			ObjectDataRegistry::FDataTypeOps Ops{Struct->GetStructureSize(), Struct->GetMinAlignment(), nullptr};
+			const int32 TypeId = ObjectDataRegistry::GetTypeRegistry().FindOrAdd(Struct->GetFName(), Ops, Struct);
+			Ptr = Mgr->AddObjectData(Obj, TypeId, [&](void* Data) { Struct->InitializeStruct(Data); });
 			Prop->CopyCompleteValueFromScriptVM(Ptr, Stack.MostRecentPropertyAddress);
-			Mgr->AddObjectData(Obj, Prop->Struct->GetFName(), SPtr);
 			bSucc = true;
 		}
 		else
@@ -245,7 +635,7 @@ DEFINE_FUNCTION(UObjectDataRegistryHelper::execDelObjectData)
 	if (auto Prop = CastField<FStructProperty>(Stack.MostRecentProperty))
 	{
 		if (auto& Mgr = ObjectDataRegistry::GetStorage())
-			Mgr->RemoveObjectData(Obj, Prop->Struct->GetFName());
+			Mgr->RemoveObjectData(Obj, ObjectDataRegistry::GetTypeRegistry().Find(Prop->Struct->GetFName()));
 	}
 }
 
@@ -255,22 +645,20 @@ void UObjectDataRegistryHelper::DeleteObjectDataByName(const UObject* KeyObj, FN
 }
 
 GS_PRIVATEACCESS_FUNCTION_NAME(UObjectDataRegistryHelper, OnActorDestroyed, void(AActor*))
-void* FObjectDataRegistry::GetDataPtr(const UObject* Obj, FName Key, const TFunctionRef<TSharedPtr<void>()>& Func)
+void* FObjectDataRegistry::GetSlotPtr(const UObject* Obj, int32 SlotId, const TFunctionRef<void(void*)>& Construct)
 {
 	void* Ret = nullptr;
 	if (auto& Mgr = ObjectDataRegistry::GetStorage(true))
 	{
-		Ret = Mgr->GetObjectData(Obj, Key);
+		Ret = Mgr->GetObjectData(Obj, SlotId);
 		if (!Ret)
 		{
-			auto Data = Func();
-			Ret = Data.Get();
 			if (auto Actor = Cast<AActor>(Obj))
 			{
 				static FName OnActorDestroyedName = PrivateAccess::UObjectDataRegistryHelper::OnActorDestroyed;
 				auto Helper = UGenericSingletons::GetSingleton<UObjectDataRegistryHelper>(Obj);
 				auto& OnDestroyed = const_cast<AActor*>(Actor)->OnDestroyed;
-				if (OnDestroyed.Contains(Helper, OnActorDestroyedName))
+				if (!OnDestroyed.Contains(Helper, OnActorDestroyedName))
 				{
 #if UE_5_03_OR_LATER
 					TBaseDynamicDelegate<FNotThreadSafeDelegateMode, void, AActor*> Delegate;
@@ -281,8 +669,13 @@ void* FObjectDataRegistry::GetDataPtr(const UObject* Obj, FName Key, const TFunc
 					OnDestroyed.Add(Delegate);
 				}
 			}
-			Mgr->AddObjectData(Obj, Key, MoveTemp(Data));
+			Ret = Mgr->AddObjectData(Obj, SlotId, Construct);
 		}
 	}
 	return Ret;
 }
+
+void* FObjectDataRegistry::GetDataPtr(const UObject* Obj, FName Key, const ObjectDataRegistry::FDataTypeOps& Ops, const TFunctionRef<void(void*)>& Construct)
+{
+	return GetSlotPtr(Obj, ObjectDataRegistry::RegisterDataType(Key, Ops), Construct);
+}
@@ -5,6 +5,8 @@
 #include "Engine/Engine.h"
 #include "Engine/World.h"
 #include "GenericSingletons.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/ScopeLock.h"
 #include "UnrealCompatibility.h"
 
 FCriticalSection UObjectPattern::Critical;
@@ -62,7 +64,7 @@ auto AllocNewStorage(int32& Index)
 {
 	if (Index == 0)
 	{
-		Index = Storage.Add(FObjectPatternType{MakeShared<FObjectPatternType::FWeakObjectArray>()});
+		Index = Storage.Add(FObjectPatternType{MakeShared<FObjectPatternType::FRegistry>()});
 	}
 	return Index;
 }
@@ -106,10 +108,200 @@ bool UObjectPattern::EditorIsGameWorld(const UObject* WorldContextObj)
 }
 #endif
 
-FObjectPatternType::FWeakObjectArray::TIterator FObjectPatternType::CreateIterator()
+static UWorld* GetRegistryWorld(const UObject* Obj)
+{
+	return Obj ? Obj->GetWorld() : nullptr;
+}
+
+static const FObjectPatternType::FSnapshotPtr& GetNullSnapshot()
+{
+	static FObjectPatternType::FSnapshotPtr NullObjects = MakeShared<FObjectPatternType::FWeakObjectArray, ESPMode::ThreadSafe>();
+	return NullObjects;
+}
+
+UObject* FObjectPatternType::FirstObject() const
+{
+	check(IsValid());
+	for (auto& Partition : Objects->Partitions)
+	{
+		if (Partition.Objects.Num() > 0)
+			return Partition.Objects[0].Get();
+	}
+	return nullptr;
+}
+
+FObjectPatternType::FPartition& FObjectPatternType::FindOrAddPartition(FObjectKey World)
+{
+	if (auto Found = Objects->Partitions.FindByPredicate([&](const FPartition& Partition) { return Partition.World == World; }))
+		return *Found;
+	auto& Partition = Objects->Partitions.AddDefaulted_GetRef();
+	Partition.World = World;
+	return Partition;
+}
+
+void FObjectPatternType::ResetSnapshots()
+{
+	for (auto& Partition : Objects->Partitions)
+		Partition.Snapshot.Reset();
+	Objects->AllSnapshot.Reset();
+}
+
+void FObjectPatternType::Add(UObject* Obj, const UWorld* World)
+{
+	check(IsValid());
+	auto& Partition = FindOrAddPartition(World);
+	Partition.Objects.Add(Obj);
+	// unresolved objects take part in every world snapshot
+	if (Partition.World == FObjectKey())
+	{
+		ResetSnapshots();
+	}
+	else
+	{
+		Partition.Snapshot.Reset();
+		Objects->AllSnapshot.Reset();
+	}
+}
+
+void FObjectPatternType::Remove(UObject* Obj)
+{
+	check(IsValid());
+	for (auto& Partition : Objects->Partitions)
+	{
+		if (Partition.Objects.Remove(Obj) > 0)
+		{
+			if (Partition.World == FObjectKey())
+				ResetSnapshots();
+			Partition.Snapshot.Reset();
+			Objects->AllSnapshot.Reset();
+			break;
+		}
+	}
+}
+
+int32 FObjectPatternType::Find(UObject* Obj) const
+{
+	check(IsValid());
+	for (auto& Partition : Objects->Partitions)
+	{
+		auto Index = Partition.Objects.Find(FWeakObjectPtr(Obj));
+		if (Index != INDEX_NONE)
+			return Index;
+	}
+	return INDEX_NONE;
+}
+
+FObjectPatternType::FSnapshotPtr FObjectPatternType::GetSnapshot(const UWorld* World)
+{
+	check(IsValid());
+	if (!World)
+	{
+		if (!Objects->AllSnapshot.IsValid())
+		{
+			auto All = MakeShared<FWeakObjectArray, ESPMode::ThreadSafe>();
+			for (auto& Partition : Objects->Partitions)
+				All->Append(Partition.Objects);
+			Objects->AllSnapshot = All;
+		}
+		return Objects->AllSnapshot;
+	}
+
+	// querying a world must not create a partition for it
+	FObjectKey Key(World);
+	auto Partition = Objects->Partitions.FindByPredicate([&](const FPartition& Cell) { return Cell.World == Key; });
+	if (Partition && Partition->Snapshot.IsValid())
+		return Partition->Snapshot;
+
+	auto Snapshot = Partition ? MakeShared<FWeakObjectArray, ESPMode::ThreadSafe>(Partition->Objects) : MakeShared<FWeakObjectArray, ESPMode::ThreadSafe>();
+	if (auto Pending = Objects->Partitions.FindByPredicate([](const FPartition& Cell) { return Cell.World == FObjectKey(); }))
+	{
+		for (auto& Weak : Pending->Objects)
+		{
+			if (GetRegistryWorld(Weak.Get()) == World)
+				Snapshot->Add(Weak);
+		}
+	}
+	if (Partition)
+		Partition->Snapshot = Snapshot;
+	return Snapshot;
+}
+
+int32 FObjectPatternType::Compact()
+{
+	check(IsValid());
+	int32 Count = 0;
+	TArray<TPair<UObject*, UWorld*>> Resolved;
+	for (auto& Partition : Objects->Partitions)
+	{
+		const bool bPending = Partition.World == FObjectKey();
+		int32 Removed = Partition.Objects.RemoveAll([&](const FWeakObjectPtr& Weak) {
+			UObject* Obj = Weak.Get();
+			if (!Obj)
+				return true;
+			if (bPending)
+			{
+				if (UWorld* World = GetRegistryWorld(Obj))
+				{
+					Resolved.Emplace(Obj, World);
+					return true;
+				}
+			}
+			return false;
+		});
+		if (Removed > 0)
+		{
+			Count += Removed;
+			Partition.Snapshot.Reset();
+		}
+	}
+
+	if (Count > 0)
+		ResetSnapshots();
+	for (auto& Pair : Resolved)
+		FindOrAddPartition(Pair.Value).Objects.Add(Pair.Key);
+	return Count;
+}
+
+void FObjectPatternType::ResolvePending(const UWorld* World)
 {
 	check(IsValid());
-	return Objects->CreateIterator();
+	auto Pending = Objects->Partitions.FindByPredicate([](const FPartition& Partition) { return Partition.World == FObjectKey(); });
+	if (!Pending || !Pending->Objects.Num())
+		return;
+
+	TArray<UObject*> Resolved;
+	Pending->Objects.RemoveAll([&](const FWeakObjectPtr& Weak) {
+		UObject* Obj = Weak.Get();
+		if (Obj && GetRegistryWorld(Obj) == World)
+		{
+			Resolved.Add(Obj);
+			return true;
+		}
+		return false;
+	});
+	if (!Resolved.Num())
+		return;
+
+	ResetSnapshots();
+	// adding the partition may reallocate Pending
+	auto& Partition = FindOrAddPartition(World);
+	for (UObject* Obj : Resolved)
+		Partition.Objects.Add(Obj);
+}
+
+void FObjectPatternType::RemoveWorld(const UWorld* World)
+{
+	check(IsValid());
+	FObjectKey Key(World);
+	if (Objects->Partitions.RemoveAll([&](const FPartition& Partition) { return Partition.World == Key; }) > 0)
+		Objects->AllSnapshot.Reset();
+}
+
+void FObjectPatternType::CollectSizes(TMap<FObjectKey, int32>& InOutSizes) const
+{
+	check(IsValid());
+	for (auto& Partition : Objects->Partitions)
+		InOutSizes.FindOrAdd(Partition.World) += Partition.Objects.Num();
 }
 
 void UObjectPattern::SetObject(UObject* Object, UClass* StopClass)
@@ -137,19 +329,71 @@ void UObjectPattern::SetObject(UObject* Object, UClass* StopClass)
 	}
 }
 
-FObjectPatternType::FWeakObjectArray::TIterator UObjectPattern::NativeIterator(int32 Index)
+FObjectPatternType::FSnapshotPtr UObjectPattern::NativeSnapshot(int32 Index, const UObject* WorldContextObj)
 {
+	// a context without a world matches nothing, only a null context walks every world
+	auto World = GetRegistryWorld(WorldContextObj);
+	if (WorldContextObj && !World)
+		return GetNullSnapshot();
+	FCSLock423 Lock;
 	if (ensure(Index > 0 && Index < ObjectPattern::Storage.Num()))
 	{
-		return ObjectPattern::Storage[Index].CreateIterator();
+		return ObjectPattern::Storage[Index].GetSnapshot(World);
 	}
-	else
+	return GetNullSnapshot();
+}
+
+FObjectPatternType::FSnapshotPtr UObjectPattern::ClassSnapshot(const UObject* WorldContextObj, UClass* Class)
+{
+	auto Mgr = Get(WorldContextObj);
+	auto World = GetRegistryWorld(WorldContextObj);
+	if (WorldContextObj && !World)
+		return GetNullSnapshot();
+	FCSLock423 Lock;
+	if (auto Found = Mgr ? Mgr->Binddings.Find(Class) : nullptr)
 	{
-		static FObjectPatternType::FWeakObjectArray NullObjects;
-		return NullObjects.CreateIterator();
+		if (Found->IsValid())
+			return Found->GetSnapshot(World);
 	}
+	return GetNullSnapshot();
 }
 
+void UObjectPattern::CompactRegistries()
+{
+	QUICK_SCOPE_CYCLE_COUNTER(STAT_ObjectPattern_CompactRegistries);
+	FCSLock423 Lock;
+	for (auto& Type : ObjectPattern::Storage)
+	{
+		if (Type.IsValid())
+			Type.Compact();
+	}
+}
+
+void UObjectPattern::DumpRegistries(FOutputDevice& Ar)
+{
+	FCSLock423 Lock;
+	TMap<FObjectKey, int32> Totals;
+	for (auto& Pair : ObjectPattern::ClassToID)
+	{
+		if (!Pair.Key.IsValid() || !ObjectPattern::Storage.IsValidIndex(Pair.Value) || !ObjectPattern::Storage[Pair.Value].IsValid())
+			continue;
+
+		TMap<FObjectKey, int32> Sizes;
+		ObjectPattern::Storage[Pair.Value].CollectSizes(Sizes);
+		for (auto& Size : Sizes)
+		{
+			Ar.Logf(TEXT("ObjectPattern %s World:%s Num:%d"), *Pair.Key->GetName(), *GetNameSafe(Size.Key.ResolveObjectPtr()), Size.Value);
+			Totals.FindOrAdd(Size.Key) += Size.Value;
+		}
+	}
+	for (auto& Total : Totals)
+	{
+		Ar.Logf(TEXT("ObjectPattern World:%s Total:%d"), *GetNameSafe(Total.Key.ResolveObjectPtr()), Total.Value);
+	}
+}
+
+static FAutoConsoleCommandWithOutputDevice DumpObjectPatternsCmd(TEXT("GenericStorages.DumpObjectPatterns"), TEXT("dump object pattern registry sizes per world"), FConsoleCommandWithOutputDeviceDelegate::CreateStatic(&UObjectPattern::DumpRegistries));
+
 UObjectPattern::UObjectPattern()
 {
 	if (!HasAnyFlags(RF_ClassDefaultObject))
@@ -158,6 +402,19 @@ UObjectPattern::UObjectPattern()
 		if (!bListened)
 		{
 			bListened = true;
+			FCoreUObjectDelegates::GetPostGarbageCollect().AddStatic(&UObjectPattern::CompactRegistries);
+			// loaded actors only know their world once the level is added
+			FWorldDelegates::LevelAddedToWorld.AddLambda([](ULevel*, UWorld* World) {
+				if (!World)
+					return;
+				QUICK_SCOPE_CYCLE_COUNTER(STAT_ObjectPattern_ResolvePending);
+				FCSLock423 Lock;
+				for (auto& Type : ObjectPattern::Storage)
+				{
+					if (Type.IsValid())
+						Type.ResolvePending(World);
+				}
+			});
 			FWorldDelegates::OnWorldCleanup.AddLambda([](UWorld* World, bool /*bSessionEnded*/, bool /*bCleanupResources*/) {
 				for (auto It = ObjectPattern::ClassToID.CreateIterator(); It;)
 				{
@@ -166,12 +423,13 @@ UObjectPattern::UObjectPattern()
 					else
 						++It;
 				}
-#if !WITH_EDITOR
-				FCSLock423 Lock;
 
-				if (auto Mgr = Get(World, false))
-					Mgr->Binddings.Empty();
-#endif
+				FCSLock423 Lock;
+				for (auto& Type : ObjectPattern::Storage)
+				{
+					if (Type.IsValid())
+						Type.RemoveWorld(World);
+				}
 			});
 		}
 	}
@@ -206,23 +464,27 @@ void UObjectPattern::EachObject(const UObject* WorldContextObj, UClass* Class, c
 	if (!EditorIsGameWorld(WorldContextObj))
 		return;
 
-	if (auto Found = Get(WorldContextObj)->Binddings.Find(Class))
+	auto Snapshot = ClassSnapshot(WorldContextObj, Class);
+	for (auto& Weak : *Snapshot)
 	{
-		for (auto It = Found->CreateIterator(); It;)
-		{
-			if (auto a = It->Get())
-			{
-				f(a);
-				++It;
-			}
-			else
-			{
-				It.RemoveCurrent();
-			}
-		}
+		if (auto a = Weak.Get())
+			f(a);
 	}
 }
 
+UObjectPattern::FDenseRegistry& UObjectPattern::GetDenseRegistry(const UClass* Class)
+{
+	// dense objects may be constructed by async loading
+	static FCriticalSection DenseCritical;
+	static TMap<const UClass*, TUniquePtr<FDenseRegistry>> DenseRegistries;
+	check(Class);
+	FScopeLock Lock(&DenseCritical);
+	auto& Registry = DenseRegistries.FindOrAdd(Class);
+	if (!Registry)
+		Registry = MakeUnique<FDenseRegistry>();
+	return *Registry;
+}
+
 int32 UObjectPattern::GetTypeID(UClass* Class)
 {
 	if (ensure(Class && ObjectPattern::ClassToID.Contains(Class)))
@@ -276,6 +538,7 @@ void UObjectPattern::AddObjectToRegistry(UObject* Object, UClass* StopClass)
 	// 	if (!EditorIsGameWorld(Object))
 	// 		return;
 
+	auto World = GetRegistryWorld(Object);
 	FCSLock423 Lock;
 	check(!Object->HasAnyFlags(RF_ClassDefaultObject | RF_ArchetypeObject));
 
@@ -290,9 +553,9 @@ void UObjectPattern::AddObjectToRegistry(UObject* Object, UClass* StopClass)
 			Found.Objects = ObjectPattern::Storage[ObjectPattern::ClassToID.FindChecked(CurClass)].Objects;
 		}
 #if WITH_EDITOR
-		ensure(Found.Objects.IsValid() && !Found.Objects->Contains(Object));
+		ensure(Found.Objects.IsValid() && Found.Find(Object) == INDEX_NONE);
 #endif
-		Found.Add(Object);
+		Found.Add(Object, World);
 	});
 }
 
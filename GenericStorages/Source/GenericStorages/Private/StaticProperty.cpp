@@ -10,6 +10,9 @@ namespace GenericStorages
 {
 	namespace Details
 	{
+#if PROPERTY_FIND_OR_ADD
+		std::atomic<uint32> PropertyGeneration{1};
+#endif
 		UStaticPropertiesContainer* GetPropertiesHolderImpl()
 		{
 			static auto Ret = [] {
@@ -19,6 +22,12 @@ namespace GenericStorages
 				if (FPlatformProperties::RequiresCookedData() && GCreateGCClusters)
 					Container->CreateCluster();
 
+#if PROPERTY_FIND_OR_ADD
+				FCoreUObjectDelegates::OnObjectsReplaced.AddLambda([](const auto&) { PropertyGeneration.fetch_add(1, std::memory_order_release); });
+#if UE_5_00_OR_LATER
+				FCoreUObjectDelegates::ReloadCompleteDelegate.AddLambda([](EReloadCompleteReason) { PropertyGeneration.fetch_add(1, std::memory_order_release); });
+#endif
+#endif
 				return Container;
 			}();
 			return Ret;
@@ -31,6 +31,104 @@ public:
 	TMap<FName, const FProperty*> NameLookups;
 };
 
+// values of one subsystem storage, carved from arena blocks in 16 byte size classes and released all at once
+struct FInstancedPropertyValPool
+{
+	static constexpr int32 Granularity = 16;
+	static constexpr int32 NumSizeClasses = 16;
+	static constexpr int32 BlockSize = 4096;
+
+	FInstancedPropertyValPool() = default;
+	FInstancedPropertyValPool(const FInstancedPropertyValPool&) = delete;
+	FInstancedPropertyValPool& operator=(const FInstancedPropertyValPool&) = delete;
+	~FInstancedPropertyValPool() { Reset(); }
+
+	FInstancedPropertyVal* Make(const FProperty* Prop, const void* Src)
+	{
+		const int32 SizeClass = GetSizeClass(Prop);
+		void* Mem = nullptr;
+		if (SizeClass == INDEX_NONE)
+		{
+			// too large or over aligned for the arena
+			Mem = FMemory::Malloc(FInstancedPropertyVal::GetAllocSize(Prop), Prop->GetMinAlignment());
+		}
+		else if (FreeLists[SizeClass])
+		{
+			Mem = FreeLists[SizeClass];
+			FreeLists[SizeClass] = *static_cast<void**>(Mem);
+		}
+		else
+		{
+			Mem = Bump((SizeClass + 1) * Granularity);
+		}
+		auto Val = new (Mem) FInstancedPropertyVal(Prop, Src);
+		Live.Add(Val);
+		return Val;
+	}
+
+	void Release(FInstancedPropertyVal* Val, bool bRecycle = true)
+	{
+		verify(Live.Remove(Val) == 1);
+		Destroy(Val, bRecycle);
+	}
+
+	// destroys the values still alive then drops the arena blocks wholesale
+	void Reset()
+	{
+		for (FInstancedPropertyVal* Val : Live)
+			Destroy(Val, false);
+		Live.Empty();
+		for (uint8* Block : Blocks)
+			FMemory::Free(Block);
+		Blocks.Empty();
+		Cursor = nullptr;
+		Remaining = 0;
+		FMemory::Memzero(FreeLists);
+	}
+
+private:
+	void Destroy(FInstancedPropertyVal* Val, bool bRecycle)
+	{
+		const int32 SizeClass = GetSizeClass(Val->Prop);
+		Val->Prop->DestroyValue(Val->Addr);
+		if (SizeClass == INDEX_NONE)
+		{
+			FMemory::Free(Val);
+		}
+		else if (bRecycle)
+		{
+			*reinterpret_cast<void**>(Val) = FreeLists[SizeClass];
+			FreeLists[SizeClass] = Val;
+		}
+	}
+
+	static int32 GetSizeClass(const FProperty* Prop)
+	{
+		// values follow the property pointer in each slot, so only its own alignment is guaranteed
+		const int32 SizeClass = (FInstancedPropertyVal::GetAllocSize(Prop) + Granularity - 1) / Granularity - 1;
+		return (SizeClass < NumSizeClasses && Prop->GetMinAlignment() <= static_cast<int32>(alignof(FInstancedPropertyVal))) ? SizeClass : INDEX_NONE;
+	}
+	void* Bump(int32 Size)
+	{
+		if (Remaining < Size)
+		{
+			Cursor = static_cast<uint8*>(FMemory::Malloc(BlockSize, Granularity));
+			Blocks.Add(Cursor);
+			Remaining = BlockSize;
+		}
+		void* Ret = Cursor;
+		Cursor += Size;
+		Remaining -= Size;
+		return Ret;
+	}
+
+	TSet<FInstancedPropertyVal*> Live;
+	TArray<uint8*> Blocks;
+	uint8* Cursor = nullptr;
+	int32 Remaining = 0;
+	void* FreeLists[NumSizeClasses] = {};
+};
+
 struct FSubsystemStorageUtils
 {
 	template<typename U>
@@ -39,6 +137,7 @@ struct FSubsystemStorageUtils
 		This->StructStores.Empty();
 		This->ObjectStores.Empty();
 		This->PropertyStores.Empty();
+		This->PropertyPool.Reset();
 	}
 
 	template<typename U>
@@ -74,18 +173,31 @@ struct FSubsystemStorageUtils
 		
 		if (Addr == nullptr || Op == EScopeSharedStorageOp::Clear)
 		{
-			return !!This->PropertyStores.Remove(KeyName);
+			FInstancedPropertyVal* Removed = nullptr;
+			if (!This->PropertyStores.RemoveAndCopyValue(KeyName, Removed))
+				return false;
+			This->PropertyPool.Release(Removed);
+			return true;
 		}
 		auto Find = This->PropertyStores.Find(KeyName);
-		if (Op == EScopeSharedStorageOp::Override || !Find || !Find->IsValid())
+		if (!Find)
+		{
+			This->PropertyStores.Add(KeyName, This->PropertyPool.Make(Prop, Addr));
+			return true;
+		}
+		if (Op == EScopeSharedStorageOp::Override)
 		{
-			if (!Find)
+			const FProperty* OldProp = (*Find)->GetProperty();
+			// SameType ignores ArrayDim, a different size would overrun the pooled value
+			if (OldProp == Prop || (OldProp->SameType(Prop) && OldProp->GetSize() == Prop->GetSize()))
 			{
-				This->PropertyStores.Emplace(KeyName, FInstancedPropertyVal::MakeDuplicate(Prop, Addr));
+				// same layout, copy in place
+				OldProp->CopyCompleteValue((*Find)->GetMutableMemory(), Addr);
 			}
 			else
 			{
-				*Find = FInstancedPropertyVal::MakeDuplicate(Prop, Addr);
+				This->PropertyPool.Release(*Find);
+				*Find = This->PropertyPool.Make(Prop, Addr);
 			}
 			return true;
 		}
@@ -135,7 +247,8 @@ protected:
 	UPROPERTY(Transient)
 	TMap<FName, TObjectPtr<const UObject>> ObjectStores;
 
-	TMap<FName, FInstancedPropertyValPtr> PropertyStores;
+	TMap<FName, FInstancedPropertyVal*> PropertyStores;
+	FInstancedPropertyValPool PropertyPool;
 };
 
 UCLASS()
@@ -157,7 +270,8 @@ protected:
 	UPROPERTY(Transient)
 	TMap<FName, TObjectPtr<const UObject>> ObjectStores;
 
-	TMap<FName, FInstancedPropertyValPtr> PropertyStores;
+	TMap<FName, FInstancedPropertyVal*> PropertyStores;
+	FInstancedPropertyValPool PropertyPool;
 };
 
 UCLASS()
@@ -178,5 +292,6 @@ protected:
 	UPROPERTY(Transient)
 	TMap<FName, TObjectPtr<const UObject>> ObjectStores;
 
-	TMap<FName, FInstancedPropertyValPtr> PropertyStores;
+	TMap<FName, FInstancedPropertyVal*> PropertyStores;
+	FInstancedPropertyValPool PropertyPool;
 };
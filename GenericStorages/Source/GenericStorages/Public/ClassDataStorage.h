@@ -6,6 +6,10 @@
 #include "Misc/CoreDelegates.h"
 #include "GenericStoragesLog.h"
 #include "Misc/CoreDelegates.h"
+#include "Misc/ScopeRWLock.h"
+#include "UObject/UObjectGlobals.h"
+
+#include <atomic>
 
 namespace ClassStorage
 {
@@ -24,24 +28,29 @@ protected:
 	{
 		return MakeShared<StorageContainerType>(Forward<Args>(args)...);
 	}
+	struct FFrozenSnapshot;
+	using FSnapshotPtr = TSharedPtr<const FFrozenSnapshot, ESPMode::ThreadSafe>;
 	struct ClassIterator
 	{
-		explicit ClassIterator(const DataPtrType& InPtr)
-			: Ptr(InPtr)
+		ClassIterator(FSnapshotPtr InOwner, const StorageContainerType* InPtr)
+			: Owner(MoveTemp(InOwner))
+			, Ptr(InPtr)
 		{
 		}
 		// we do not return sharedptr type.
-		FORCEINLINE const StorageContainerType& operator*() const { return *GetRaw(Ptr); }
-		FORCEINLINE const StorageContainerType* operator->() const { return GetRaw(Ptr); }
+		FORCEINLINE const StorageContainerType& operator*() const { return *Ptr; }
+		FORCEINLINE const StorageContainerType* operator->() const { return Ptr; }
 		FORCEINLINE explicit operator bool() { return Ptr != nullptr; }
 		FORCEINLINE ClassIterator& operator++()
 		{
-			Ptr = Ptr->Super;
+			Ptr = Ptr->GetSuper();
 			return *this;
 		}
 
 	private:
-		DataPtrType Ptr;
+		// keeps the nodes alive while iterating off the game thread
+		FSnapshotPtr Owner;
+		const StorageContainerType* Ptr;
 	};
 
 	//////////////////////////////////////////////////////////////////////////
@@ -53,13 +62,233 @@ protected:
 
 		const StorageContainerType* GetSuper() const { return GetRaw(Super); }
 	};
-	TMap<TWeakObjectPtr<const UStruct>, DataPtrType> PersistentData;
-	TMap<TWeakObjectPtr<const UStruct>, DataPtrType> RegisteredData;
-	mutable TMap<TWeakObjectPtr<const UStruct>, DataPtrType> FastLookupTable;
+
+	// each node links to its nearest registered ancestor
+	struct FClassTree
+	{
+		TMap<TWeakObjectPtr<const UStruct>, DataPtrType> Nodes;
+		// registered nodes keyed by each unregistered class between them and their nearest registered ancestor
+		TMap<TWeakObjectPtr<const UStruct>, TArray<StorageContainerType*>> Pending;
+
+		void Reset()
+		{
+			Nodes.Reset();
+			Pending.Reset();
+		}
+	};
+	FClassTree PersistentData;
+	FClassTree RegisteredData;
 	mutable bool bEnableAdd = true;
 
+	// flat table indexed by UStruct internal index and paged to keep it sparse
+	struct FFrozenTable
+	{
+		static constexpr int32 PageBits = 10;
+		static constexpr int32 PageMask = (1 << PageBits) - 1;
+		TArray<TArray<const StorageContainerType*>> Pages;
+
+		FORCEINLINE const StorageContainerType* Get(int32 Index) const
+		{
+			const int32 PageIdx = Index >> PageBits;
+			return (Pages.IsValidIndex(PageIdx) && Pages[PageIdx].Num()) ? Pages[PageIdx].GetData()[Index & PageMask] : nullptr;
+		}
+		void Set(int32 Index, const StorageContainerType* Node)
+		{
+			const int32 PageIdx = Index >> PageBits;
+			if (PageIdx >= Pages.Num())
+				Pages.SetNum(PageIdx + 1);
+			if (!Pages[PageIdx].Num())
+				Pages[PageIdx].SetNumZeroed(1 << PageBits);
+			Pages[PageIdx][Index & PageMask] = Node;
+		}
+	};
+
+	// immutable copy of RegisteredData, never modified once published so any thread could read it
+	struct FFrozenSnapshot
+	{
+		TArray<DataPtrType> Nodes;
+		FFrozenTable Table;
+
+		const StorageContainerType* Find(const UStruct* Class) const
+		{
+			for (auto CurrentClass = Class; CurrentClass != nullptr; CurrentClass = CurrentClass->GetSuperStruct())
+			{
+				if (auto Node = Table.Get(CurrentClass->GetUniqueID()))
+					return Node;
+			}
+			return nullptr;
+		}
+	};
+
+	// published snapshot, guarded by SnapshotLock together with RegisteredData writes
+	mutable FRWLock SnapshotLock;
+	mutable FSnapshotPtr Snapshot;
+	// replaced snapshots, kept alive so raw pointers handed out stay valid until next garbage collection
+	mutable TArray<FSnapshotPtr> RetiredSnapshots;
+	mutable bool bSnapshotDirty = true;
+	// bumped on each publish so that the game thread notices snapshots built by other threads
+	mutable std::atomic<uint32> SnapshotSerial{0};
+
+	// game thread only : no lock nor refcount, lookups are memoized including misses
+	mutable const FFrozenSnapshot* GameThreadSnapshot = nullptr;
+	mutable uint32 GameThreadSerial = 0;
+	mutable FFrozenTable GameThreadTable;
+
+	// marks types resolved to no data, distinguishes them from unresolved slots
+	static const StorageContainerType* GetNullNode()
+	{
+		static const StorageContainerType NullNode{};
+		return &NullNode;
+	}
+
+	// caller holds SnapshotLock for writing
+	void FreezeLocked() const
+	{
+		TSharedPtr<FFrozenSnapshot, ESPMode::ThreadSafe> NewSnapshot = MakeShared<FFrozenSnapshot, ESPMode::ThreadSafe>();
+		TMap<const StorageContainerType*, DataPtrType> Copies;
+		Copies.Reserve(RegisteredData.Nodes.Num());
+		NewSnapshot->Nodes.Reserve(RegisteredData.Nodes.Num());
+		for (const auto& a : RegisteredData.Nodes)
+		{
+			if (!a.Key.IsValid())
+				continue;
+			auto Copy = AllocShared();
+			Copy->KeyClass = a.Value->KeyClass;
+			Copy->Data = a.Value->Data;
+			NewSnapshot->Table.Set(a.Key->GetUniqueID(), GetRaw(Copy));
+			NewSnapshot->Nodes.Add(Copy);
+			Copies.Add(GetRaw(a.Value), MoveTemp(Copy));
+		}
+		for (const auto& a : RegisteredData.Nodes)
+		{
+			if (auto Copy = Copies.Find(GetRaw(a.Value)))
+			{
+				// nearest valid registered ancestor
+				for (auto Super = a.Value->GetSuper(); Super; Super = Super->GetSuper())
+				{
+					if (auto SuperCopy = Copies.Find(Super))
+					{
+						(*Copy)->Super = *SuperCopy;
+						break;
+					}
+				}
+			}
+		}
+
+		if (Snapshot)
+			RetiredSnapshots.Add(MoveTemp(Snapshot));
+		Snapshot = MoveTemp(NewSnapshot);
+		bSnapshotDirty = false;
+		SnapshotSerial.fetch_add(1, std::memory_order_release);
+#if !UE_BUILD_SHIPPING
+		UE_LOG(LogGenericStorages, Log, TEXT("TClassDataStorage::Freeze %d types"), RegisteredData.Nodes.Num());
+#endif
+	}
+
+	void Freeze() const
+	{
+		FRWScopeLock Lock(SnapshotLock, SLT_Write);
+		FreezeLocked();
+	}
+
+	// any thread : game thread writers hold the lock while mutating, so a stale snapshot could be rebuilt here
+	FSnapshotPtr GetSnapshot() const
+	{
+		{
+			FRWScopeLock Lock(SnapshotLock, SLT_ReadOnly);
+			if (!bSnapshotDirty)
+				return Snapshot;
+		}
+		FRWScopeLock Lock(SnapshotLock, SLT_Write);
+		if (bSnapshotDirty)
+			FreezeLocked();
+		return Snapshot;
+	}
+
+	FORCEINLINE bool IsGameThreadSynced() const { return GameThreadSnapshot && GameThreadSerial == SnapshotSerial.load(std::memory_order_relaxed); }
+	void SyncGameThread() const
+	{
+		check(IsInGameThread());
+		{
+			FRWScopeLock Lock(SnapshotLock, SLT_Write);
+			if (bSnapshotDirty || !Snapshot)
+				FreezeLocked();
+			GameThreadSnapshot = Snapshot.Get();
+			GameThreadSerial = SnapshotSerial.load(std::memory_order_relaxed);
+		}
+		GameThreadTable.Pages.Reset();
+	}
+
+	const StorageContainerType* FindOnGameThread(const UStruct* Class) const
+	{
+		// auto lock : at first query, no more data needed
+		if (bAutoLock)
+			bEnableAdd = false;
+		if (UNLIKELY(!IsGameThreadSynced()))
+			SyncGameThread();
+
+		checkSlow(Class);
+		const StorageContainerType* Node = GameThreadTable.Get(Class->GetUniqueID());
+		if (UNLIKELY(!Node))
+		{
+			Node = GameThreadSnapshot->Find(Class);
+			if (!Node)
+				Node = GetNullNode();
+			GameThreadTable.Set(Class->GetUniqueID(), Node);
+		}
+		return Node != GetNullNode() ? Node : nullptr;
+	}
+
+	// game thread writers : callbacks run unlocked on a copy, snapshot builders read the nodes under the lock
+	DataPtrType* AddRegistered(const UStruct* Class, bool bEnsure)
+	{
+		bool bNewCreated = false;
+		FRWScopeLock Lock(SnapshotLock, SLT_Write);
+		auto DataPtr = Add(RegisteredData, Class, bEnsure, &bNewCreated);
+		if (bNewCreated)
+		{
+			bSnapshotDirty = true;
+			GameThreadSnapshot = nullptr;
+		}
+		return DataPtr;
+	}
+	template<typename F>
+	void WriteNode(const DataPtrType& Node, const F& Fun)
+	{
+		StorageDataType Data = Node->Data;
+		Fun(Data);
+		FRWScopeLock Lock(SnapshotLock, SLT_Write);
+		Node->Data = MoveTemp(Data);
+		bSnapshotDirty = true;
+		GameThreadSnapshot = nullptr;
+	}
+	void OnPostGarbageCollect()
+	{
+		// internal indices of collected types could be reused
+		GameThreadSnapshot = nullptr;
+		GameThreadTable.Pages.Reset();
+
+		TArray<FSnapshotPtr> Released;
+		{
+			FRWScopeLock Lock(SnapshotLock, SLT_Write);
+			Released = MoveTemp(RetiredSnapshots);
+			// only rebuild when a registered type got collected
+			if (Snapshot && !bSnapshotDirty)
+			{
+				for (const auto& Node : Snapshot->Nodes)
+				{
+					if (!Node->KeyClass.IsValid())
+					{
+						bSnapshotDirty = true;
+						break;
+					}
+				}
+			}
+		}
+	}
+
 	//////////////////////////////////////////////////////////////////////////
-	DataPtrType* Add(TMap<TWeakObjectPtr<const UStruct>, DataPtrType>& Regs, const UStruct* Class, bool bEnsure, bool* bNewCreated = nullptr)
+	DataPtrType* Add(FClassTree& Regs, const UStruct* Class, bool bEnsure, bool* bNewCreated = nullptr)
 	{
 #if !UE_BUILD_SHIPPING
 		UE_LOG(LogGenericStorages, Log, TEXT("TClassDataStorage::Add %s"), *Class->GetName());
@@ -67,58 +296,43 @@ protected:
 		if (bEnsure && !ensureAlwaysMsgf(bEnableAdd, TEXT("TClassDataStorage cannot add data anymore")))
 			return nullptr;
 
-		auto& Ptr = Regs.FindOrAdd(Class);
+		auto& Ptr = Regs.Nodes.FindOrAdd(Class);
 		if (!Ptr)
 		{
 			Ptr = AllocShared();
 			if (bNewCreated)
 				*bNewCreated = true;
 			Ptr->KeyClass = Class;
-			for (auto& a : Regs)
+
+			// nearest registered ancestor : O(depth)
+			for (auto ParentClass = Class->GetSuperStruct(); ParentClass != nullptr; ParentClass = ParentClass->GetSuperStruct())
 			{
-				if (a.Key.IsValid() && a.Key->IsChildOf(Class) && a.Key.Get() != Class)
+				if (auto InnerPtr = Regs.Nodes.Find(ParentClass))
 				{
-					for (auto CurPtr = a.Value; CurPtr; CurPtr = CurPtr->Super)
-					{
-						auto SuperPtr = CurPtr->Super;
-						if (!SuperPtr)
-						{
-#if !UE_BUILD_SHIPPING
-							UE_LOG(LogGenericStorages, Log, TEXT("TClassDataStorage::AddParent %s -> %s"), *CurPtr->KeyClass->GetName(), *Class->GetName());
-#endif
-							CurPtr->Super = Ptr;
-							break;
-						}
-						else if (Class == SuperPtr->KeyClass)
-						{
-#if !UE_BUILD_SHIPPING
-							UE_LOG(LogGenericStorages, Log, TEXT("TClassDataStorage::AlreadyAdded %s -> %s"), *CurPtr->KeyClass->GetName(), *Class->GetName());
-#endif
-							break;
-						}
-						else if (SuperPtr->KeyClass.IsValid() && Class->IsChildOf(SuperPtr->KeyClass.Get()))
-						{
 #if !UE_BUILD_SHIPPING
-							UE_LOG(LogGenericStorages, Log, TEXT("TClassDataStorage::Inserted %s-> %s -> %s"), *CurPtr->KeyClass->GetName(), *Class->GetName(), *SuperPtr->KeyClass->GetName());
+					UE_LOG(LogGenericStorages, Log, TEXT("TClassDataStorage::AddedChild %s -> %s"), *Class->GetName(), *ParentClass->GetName());
 #endif
-							Ptr->Super = CurPtr->Super;
-							CurPtr->Super = Ptr;
-							break;
-						}
-					}
+					Ptr->Super = *InnerPtr;
+					break;
 				}
+				Regs.Pending.FindOrAdd(ParentClass).Add(GetRaw(Ptr));
 			}
-			if (!Ptr->Super)
+
+			// only registered descendants which reached Class through unregistered classes could need relinking
+			TArray<StorageContainerType*> Descendants;
+			if (Regs.Pending.RemoveAndCopyValue(Class, Descendants))
 			{
-				for (auto ParentClass = Class->GetSuperStruct(); ParentClass != nullptr; ParentClass = ParentClass->GetSuperStruct())
+				for (auto* Desc : Descendants)
 				{
-					if (auto InnerPtr = Regs.Find(ParentClass))
+					// skip those already linked to a registered class below Class
+					auto* OldSuper = GetRaw(Desc->Super);
+					if (!OldSuper || !OldSuper->KeyClass.IsValid() || Class->IsChildOf(OldSuper->KeyClass.Get()))
 					{
 #if !UE_BUILD_SHIPPING
-						UE_LOG(LogGenericStorages, Log, TEXT("TClassDataStorage::AddedChild %s -> %s"), *Class->GetName(), *ParentClass->GetName());
+						if (Desc->KeyClass.IsValid())
+							UE_LOG(LogGenericStorages, Log, TEXT("TClassDataStorage::Inserted %s -> %s"), *Desc->KeyClass->GetName(), *Class->GetName());
 #endif
-						Ptr->Super = *InnerPtr;
-						break;
+						Desc->Super = Ptr;
 					}
 				}
 			}
@@ -126,39 +340,21 @@ protected:
 		return &Ptr;
 	};
 
-	DataPtrType Find(const UStruct* Class, bool bNewDisable = true) const
+	// writers resolve through RegisteredData, readers through the snapshot
+	DataPtrType FindRegistered(const UStruct* Class) const
 	{
-		// auto lock : at first query, no more data needed
-		if (bAutoLock && bNewDisable)
-			SetEnableState(false);
-
 		checkSlow(Class);
-
-		if (auto FindPtr = FastLookupTable.Find(Class))
-			return *FindPtr;
-
-		DataPtrType& Ptr = FastLookupTable.Add(Class);
-#if !UE_BUILD_SHIPPING
-		UE_LOG(LogGenericStorages, Log, TEXT("TClassDataStorage::FastLookupTable Add %s"), *Class->GetName());
-#endif
 		for (auto CurrentClass = Class; CurrentClass != nullptr; CurrentClass = CurrentClass->GetSuperStruct())
 		{
-			if (auto InnerPtr = RegisteredData.Find(CurrentClass))
-			{
-#if !UE_BUILD_SHIPPING
-				UE_LOG(LogGenericStorages, Log, TEXT("TClassDataStorage::FastLookupTable %s -> %s"), *Class->GetName(), *CurrentClass->GetName());
-#endif
-				Ptr = *InnerPtr;
-				break;
-			}
+			if (auto InnerPtr = RegisteredData.Nodes.Find(CurrentClass))
+				return *InnerPtr;
 		}
-		return Ptr;
+		return nullptr;
 	}
 	void Clean()
 	{
 		UE_LOG(LogGenericStorages, Log, TEXT("TClassDataStorage::Clean"));
 #if 0
-		FastLookupTable.Reset();
 		RegisteredData.Reset();
 		PersistentData.Reset();
 		SetEnableState(true);
@@ -168,51 +364,120 @@ protected:
 	void Clear()
 	{
 		UE_LOG(LogGenericStorages, Log, TEXT("TClassDataStorage::Clear"));
-		FastLookupTable.Reset();
-		RegisteredData.Reset();
 		SetEnableState(true);
 
-		for (const auto& a : PersistentData)
+		FRWScopeLock Lock(SnapshotLock, SLT_Write);
+		RegisteredData.Reset();
+		// relinking goes through the same incremental index
+		for (const auto& a : PersistentData.Nodes)
 		{
 			if (a.Key.IsValid())
-				RegisteredData.Add(a.Key.Get(), AllocShared(*a.Value));
-		}
-
-		for (auto& Pair : RegisteredData)
-		{
-			DataPtrType& Value = Pair.Value;
-			if (Value && Value->Super)
 			{
-				auto SuperClass = Value->Super->KeyClass;
-				Value->Super = nullptr;
-				if (auto Ptr = RegisteredData.Find(SuperClass))
-					Value->Super = *Ptr;
+				if (auto DataPtr = Add(RegisteredData, a.Key.Get(), false))
+					(*DataPtr)->Data = a.Value->Data;
 			}
 		}
+		// readers rebuild on their next query
+		bSnapshotDirty = true;
+		GameThreadSnapshot = nullptr;
 	}
 
+	struct FSnapshotIterator
+	{
+		explicit FSnapshotIterator(FSnapshotPtr InOwner)
+			: Owner(MoveTemp(InOwner))
+		{
+		}
+		FORCEINLINE const TWeakObjectPtr<const UStruct>& Key() const { return Owner->Nodes[Index]->KeyClass; }
+		FORCEINLINE const StorageContainerType& operator*() const { return *Owner->Nodes[Index]; }
+		FORCEINLINE const StorageContainerType* operator->() const { return GetRaw(Owner->Nodes[Index]); }
+		FORCEINLINE explicit operator bool() { return Owner && Owner->Nodes.IsValidIndex(Index); }
+		FORCEINLINE FSnapshotIterator& operator++()
+		{
+			++Index;
+			return *this;
+		}
+
+	private:
+		FSnapshotPtr Owner;
+		int32 Index = 0;
+	};
+
 public:
 	TClassStorageImpl()
 	{
 		static_assert(std::is_copy_assignable<StorageDataType>::value, "err");
 		FCoreDelegates::OnEnginePreExit.AddRaw(this, &TClassStorageImpl::Clean);
+		FCoreUObjectDelegates::GetPostGarbageCollect().AddRaw(this, &TClassStorageImpl::OnPostGarbageCollect);
+	}
+	~TClassStorageImpl()
+	{
+		FCoreDelegates::OnEnginePreExit.RemoveAll(this);
+		FCoreUObjectDelegates::GetPostGarbageCollect().RemoveAll(this);
 	}
 
 	void Cleanup() { Clear(); }
 
-	void SetEnableState(bool bNewEanbled) const { bEnableAdd = bNewEanbled; }
+	void SetEnableState(bool bNewEanbled) const
+	{
+		bEnableAdd = bNewEanbled;
+		if (!bNewEanbled && IsInGameThread() && !IsGameThreadSynced())
+			SyncGameThread();
+	}
 
-	StorageDataType* FindData(const UStruct* Class) const
+	// results stay valid until next garbage collection, other threads could hold them with FindSharedData instead
+	const StorageDataType* FindData(const UStruct* Class) const
+	{
+		if (!Class)
+			return nullptr;
+		const StorageContainerType* Node = nullptr;
+		if (IsInGameThread())
+		{
+			Node = FindOnGameThread(Class);
+		}
+		else if (FSnapshotPtr Frozen = GetSnapshot())
+		{
+			Node = Frozen->Find(Class);
+		}
+		return Node ? &Node->Data : (const StorageDataType*)nullptr;
+	}
+	// game thread only, points into the registered data and stays valid until Cleanup
+	// the snapshot is assumed modified and rebuilt on next query, prefer the const overload or ModifyData
+	StorageDataType* FindData(const UStruct* Class)
+	{
+		check(IsInGameThread());
+		if (bAutoLock)
+			bEnableAdd = false;
+		DataPtrType Node = Class ? FindRegistered(Class) : nullptr;
+		if (!Node)
+			return nullptr;
+		FRWScopeLock Lock(SnapshotLock, SLT_Write);
+		bSnapshotDirty = true;
+		GameThreadSnapshot = nullptr;
+		return &Node->Data;
+	}
+	TSharedPtr<const StorageDataType, ESPMode::ThreadSafe> FindSharedData(const UStruct* Class) const
+	{
+		if (bAutoLock && IsInGameThread())
+			SetEnableState(false);
+		FSnapshotPtr Frozen = Class ? GetSnapshot() : FSnapshotPtr();
+		auto Node = Frozen ? Frozen->Find(Class) : nullptr;
+		return Node ? TSharedPtr<const StorageDataType, ESPMode::ThreadSafe>(Frozen, &Node->Data) : nullptr;
+	}
+	// safe from any thread, game thread iterations do not outlive a garbage collection
+	auto CreateIterator(const UStruct* Class) const
 	{
-		DataPtrType Ptr = Class ? Find(Class) : nullptr;
-		return Ptr ? &Ptr->Data : (StorageDataType*)nullptr;
+		if (IsInGameThread())
+			return ClassIterator(nullptr, Class ? FindOnGameThread(Class) : nullptr);
+		FSnapshotPtr Frozen = GetSnapshot();
+		auto Node = (Frozen && Class) ? Frozen->Find(Class) : nullptr;
+		return ClassIterator(MoveTemp(Frozen), Node);
 	}
-	auto CreateIterator(const UStruct* Class) const { return ClassIterator(Find(Class)); }
-	auto CreateIterator() const { return RegisteredData.CreateConstIterator(); }
+	auto CreateIterator() const { return FSnapshotIterator(GetSnapshot()); }
 	auto GetKeys()
 	{
 		TArray<TWeakObjectPtr<const UStruct>> Keys;
-		RegisteredData.GetKeys(Keys);
+		RegisteredData.Nodes.GetKeys(Keys);
 		return Keys;
 	}
 	template<typename F /*void(auto&)*/>
@@ -231,10 +496,10 @@ public:
 				}
 			}
 
-			if (auto DataPtr = Add(RegisteredData, Class, bPrompt))
+			if (auto DataPtr = AddRegistered(Class, bPrompt))
 			{
-				Fun((*DataPtr)->Data);
-				FastLookupTable.FindOrAdd(Class) = *DataPtr;
+				DataPtrType Node = *DataPtr;
+				WriteNode(Node, Fun);
 			}
 		}
 	}
@@ -246,19 +511,21 @@ public:
 #if !UE_BUILD_SHIPPING
 			UE_LOG(LogGenericStorages, Log, TEXT("TClassDataStorage::Modify Current %s"), *Class->GetName());
 #endif
-			if (auto ClassPtr = Find(Class))
+			// auto lock as a query would, the snapshot is only rebuilt on the next read
+			if (bAutoLock)
+				bEnableAdd = false;
+			if (auto ClassPtr = FindRegistered(Class))
 			{
-				Fun(ClassPtr->Data, true);
-				FastLookupTable.FindOrAdd(Class) = ClassPtr;
+				WriteNode(ClassPtr, [&](StorageDataType& Data) { Fun(Data, true); });
 			}
 			else
 			{
 				if (bEnable)
 					SetEnableState(true);
-				if (auto DataPtr = Add(RegisteredData, Class, true))
+				if (auto DataPtr = AddRegistered(Class, true))
 				{
-					Fun((*DataPtr)->Data, false);
-					FastLookupTable.FindOrAdd(Class) = *DataPtr;
+					DataPtrType Node = *DataPtr;
+					WriteNode(Node, [&](StorageDataType& Data) { Fun(Data, false); });
 				}
 			}
 		}
@@ -22,6 +22,26 @@ public:
 		UObjectPattern::EachObject<T>(WorldContextObj, f);
 	}
 
+	template<typename T, typename F>
+	static void ParallelEachComponent(const UObject* WorldContextObj, const F& Fn, int32 MinBatch = 256)
+	{
+		static_assert(TIsDerivedFrom<T, UActorComponent>::IsDerived && !std::is_same<T, UActorComponent>::value, "err");
+		UObjectPattern::ParallelEachObject<T>(WorldContextObj, Fn, MinBatch);
+	}
+	template<typename T, typename TContext, typename F>
+	static void ParallelEachComponentWithContext(const UObject* WorldContextObj, TArray<TContext>& OutContexts, const F& Fn, int32 MinBatch = 256)
+	{
+		static_assert(TIsDerivedFrom<T, UActorComponent>::IsDerived && !std::is_same<T, UActorComponent>::value, "err");
+		UObjectPattern::ParallelEachObjectWithContext<T>(WorldContextObj, OutContexts, Fn, MinBatch);
+	}
+
+	template<typename T, typename F>
+	static void EachDenseComponent(const F& f)
+	{
+		static_assert(TIsDerivedFrom<T, UActorComponent>::IsDerived && !std::is_same<T, UActorComponent>::value, "err");
+		UObjectPattern::EachDenseObject<T>(f);
+	}
+
 	DECLARE_DYNAMIC_DELEGATE_OneParam(FOnEachComponentAction, UActorComponent*, Comp);
 	UFUNCTION(BlueprintCallable, BlueprintInternalUseOnly, Category = "Game", meta = (NeuronAction, DisplayName = "EachComponent", WorldContext = "WorldContextObj", HidePin = "WorldContextObj"))
 	static void EachComponent(const UObject* WorldContextObj, TSubclassOf<UActorComponent> Class, UPARAM(meta = (DeterminesOutputType = "Class", DynamicOutputParam = "Comp")) FOnEachComponentAction OnEachComp)
@@ -67,6 +87,21 @@ protected:
 	using TEachObjectPattern<T>::Dtor;
 };
 
+template<typename T, typename V = void>
+struct TDenseComponentPattern : public TDenseObjectPattern<T>
+{
+	TDenseComponentPattern()
+	{
+		static_assert(TIsDerivedFrom<T, UActorComponent>::IsDerived && !std::is_same<T, UActorComponent>::value, "err");
+		Ctor(static_cast<T*>(this));
+	}
+	~TDenseComponentPattern() { Dtor(static_cast<T*>(this)); }
+
+protected:
+	using TDenseObjectPattern<T>::Ctor;
+	using TDenseObjectPattern<T>::Dtor;
+};
+
 template<typename T, typename V = void>
 struct TSingleComponentPattern : public TSingleObjectPattern<T>
 {
@@ -7,6 +7,7 @@
 #include "Engine/World.h"
 #include "Kismet/BlueprintFunctionLibrary.h"
 #include "Templates/SubclassOf.h"
+#include "UObject/Interface.h"
 
 #include "DeferredComponentRegistry.generated.h"
 
@@ -57,6 +58,23 @@ struct FRegClassData
 using FRegClassDataArray = TArray<FRegClassData>;
 }  // namespace DeferredComponentRegistry
 
+UINTERFACE(meta = (CannotImplementInterfaceInBlueprint))
+class UDeferredComponentPoolable : public UInterface
+{
+	GENERATED_BODY()
+};
+
+// reset hooks for deferred components recycled by the pool
+class GENERICSTORAGES_API IDeferredComponentPoolable
+{
+	GENERATED_BODY()
+public:
+	// the component has left its owner and is parked in the pool
+	virtual void OnDeferredComponentRecycled() {}
+	// the component has been attached to a new owner and is about to register
+	virtual void OnDeferredComponentReused(AActor& NewOwner) {}
+};
+
 UCLASS()
 class GENERICSTORAGES_API UDeferredComponentRegistry final : public UBlueprintFunctionLibrary
 {
@@ -77,6 +95,10 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Game", meta = (CallableWithoutWorldContext = true))
 	static void EnableAdd(bool bNewEnabled);
 
+	// opt-in pooling for deferred components of high-churn actors, MaxPoolSize <= 0 disables and flushes the pool
+	UFUNCTION(BlueprintCallable, Category = "Game", meta = (CallableWithoutWorldContext = true))
+	static void SetDeferredComponentPooled(TSubclassOf<UActorComponent> ComponentClass, int32 MaxPoolSize = 16);
+
 	static uint8 GetMode(uint8 InFlags, TSubclassOf<UActorComponent> InClass);
 	static void ModifyDeferredComponents(TSubclassOf<AActor> Class, TFunctionRef<void(DeferredComponentRegistry::FRegClassDataArray&)> Cb, bool bPersistent = false);
 };
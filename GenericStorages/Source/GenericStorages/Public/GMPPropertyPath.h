@@ -1,8 +1,10 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "StaticProperty.h"
 #include "UnrealCompatibility.h"
 #if UE_4_25_OR_LATER
+#include "Misc/StringBuilder.h"
 #include "UObject/UnrealType.h"
 #include "UObject/WeakFieldPtr.h"
 
@@ -27,6 +29,167 @@ public:
 
 	TWeakFieldPtr<FProperty> Property;
 	int32 ArrayIndex;
+
+	// paths fold these with HashCombine from root to leaf
+	FORCEINLINE uint32 GetHash() const { return HashCombine(PointerHash(Property.Get()), ::GetTypeHash(ArrayIndex)); }
+};
+
+class FGMPPropertyPath;
+
+// a property path resolved once into raw offsets, reading or writing the leaf is then a tight loop
+// it is not updated when the structs of the path are recompiled, check IsValid() before a batch
+struct FGMPCompiledPropertyPath
+{
+public:
+	enum class EStepKind : uint8
+	{
+		Offset,
+		ArrayElement,
+		Object,
+	};
+
+	struct FStep
+	{
+		EStepKind Kind;
+		int32 Offset;
+		int32 ElementSize;
+		int32 Index;
+		const FObjectPropertyBase* ObjectProp;
+		// class owning the members after an object step
+		const UClass* OwnerClass;
+	};
+
+	static FGMPCompiledPropertyPath Compile(TArrayView<const FGMPPropertyInfo> Path);
+
+	// every property and struct along the path must still be alive
+	bool IsValid() const
+	{
+		if (!LeafProp)
+			return false;
+		for (const auto& WeakProp : WeakProps)
+		{
+			if (!WeakProp.IsValid())
+				return false;
+		}
+		for (const auto& WeakStruct : WeakStructs)
+		{
+			if (!WeakStruct.IsValid())
+				return false;
+		}
+		return true;
+	}
+	const UStruct* GetRootStruct() const { return RootStruct; }
+	const FProperty* GetLeafProperty() const { return LeafProp; }
+
+	// returns the leaf address inside the container, nullptr if an array index or an object ref along the path is invalid
+	void* Resolve(void* Container) const
+	{
+		uint8* Ptr = static_cast<uint8*>(Container);
+		for (const FStep& Step : Steps)
+		{
+			switch (Step.Kind)
+			{
+				case EStepKind::Offset:
+					Ptr += Step.Offset;
+					break;
+				case EStepKind::ArrayElement:
+				{
+					FScriptArray* Array = reinterpret_cast<FScriptArray*>(Ptr);
+					if (!Array->IsValidIndex(Step.Index))
+						return nullptr;
+					Ptr = static_cast<uint8*>(Array->GetData()) + Step.Index * Step.ElementSize;
+					break;
+				}
+				case EStepKind::Object:
+				{
+					UObject* Obj = Step.ObjectProp->GetObjectPropertyValue(Ptr);
+					if (!Obj || !Obj->IsA(Step.OwnerClass))
+						return nullptr;
+					Ptr = reinterpret_cast<uint8*>(Obj);
+					break;
+				}
+			}
+		}
+		return Ptr;
+	}
+	const void* Resolve(const void* Container) const { return Resolve(const_cast<void*>(Container)); }
+
+	void* ResolveObject(const UObject* Obj) const { return (Obj && RootClass && Obj->IsA(RootClass)) ? Resolve((void*)Obj) : nullptr; }
+
+	template<typename T>
+	T* ResolveAs(const UObject* Obj) const
+	{
+		return static_cast<T*>(ResolveObject(Obj));
+	}
+
+	// Fn(UObject*, void* LeafPtr), objects which can not be resolved are skipped, returns the number visited
+	template<typename F>
+	int32 ForEachValue(TArrayView<UObject* const> Objects, const F& Fn) const
+	{
+		int32 Count = 0;
+		if (!IsValid() || !RootClass)
+			return Count;
+		for (UObject* Obj : Objects)
+		{
+			if (void* Ptr = ResolveObject(Obj))
+			{
+				Fn(Obj, Ptr);
+				++Count;
+			}
+		}
+		return Count;
+	}
+
+	int32 SetValues(TArrayView<UObject* const> Objects, const void* Value) const
+	{
+		if (bLeafPlainOldData)
+			return ForEachValue(Objects, [&](UObject*, void* Ptr) { FMemory::Memcpy(Ptr, Value, LeafSize); });
+		return ForEachValue(Objects, [&](UObject*, void* Ptr) { LeafProp->CopySingleValue(Ptr, Value); });
+	}
+
+	// unresolved objects get a default value so OutValues stays parallel to Objects
+	// T must be the exact leaf type, object leaves included
+	template<typename T>
+	void GetValues(TArrayView<UObject* const> Objects, TArray<T>& OutValues) const
+	{
+		check(!LeafProp || (LeafSize == sizeof(T) && LeafProp->SameType(GenericStorages::StaticProperty<T>())));
+		OutValues.Reset(Objects.Num());
+		for (UObject* Obj : Objects)
+		{
+			T& Value = OutValues.AddDefaulted_GetRef();
+			if (const void* Ptr = IsValid() ? ResolveObject(Obj) : nullptr)
+			{
+				if (bLeafPlainOldData)
+					FMemory::Memcpy(&Value, Ptr, LeafSize);
+				else
+					LeafProp->CopySingleValue(&Value, Ptr);
+			}
+		}
+	}
+
+private:
+	friend class FGMPPropertyPath;
+#if UE_5_05_OR_LATER
+	static int32 GetPropElementSize(const FProperty* Prop) { return Prop->GetElementSize(); }
+#else
+	static int32 GetPropElementSize(const FProperty* Prop) { return Prop->ElementSize; }
+#endif
+	void AddOffset(int32 Offset)
+	{
+		if (Steps.Num() && Steps.Last().Kind == EStepKind::Offset)
+			Steps.Last().Offset += Offset;
+		else
+			Steps.Add(FStep{EStepKind::Offset, Offset, 0, INDEX_NONE, nullptr, nullptr});
+	}
+
+	TArray<FStep, TInlineAllocator<4>> Steps;
+	const UStruct* RootStruct = nullptr;
+	const UClass* RootClass = nullptr;
+	const FProperty* LeafProp = nullptr;
+	TArray<TWeakFieldPtr<FProperty>, TInlineAllocator<4>> WeakProps;
+	TArray<TWeakObjectPtr<const UStruct>, TInlineAllocator<2>> WeakStructs;
+	int32 LeafSize = 0;
+	bool bLeafPlainOldData = false;
 };
 
 class FGMPPropertyPath
@@ -49,6 +212,8 @@ public:
 
 	int32 GetNumProperties() const { return Properties.Num(); }
 
+	TArrayView<const FGMPPropertyInfo> GetProperties() const { return Properties; }
+
 	const FGMPPropertyInfo& GetPropertyInfo(int32 index) const { return Properties[index]; }
 
 	const FGMPPropertyInfo& GetLeafMostProperty() const { return Properties[Properties.Num() - 1]; }
@@ -105,32 +270,38 @@ public:
 		return NewPath;
 	}
 
-	FString ToString(const TCHAR* Separator = TEXT("->")) const
+	// array properties are skipped unless they are the leaf, their element carries the index
+	static void AppendString(FStringBuilderBase& Builder, TArrayView<const FGMPPropertyInfo> InProperties, const TCHAR* Separator = TEXT("->"))
 	{
-		FString NewDisplayName;
 		bool FirstAddition = true;
-		for (int PropertyIndex = 0; PropertyIndex < Properties.Num(); PropertyIndex++)
+		for (int PropertyIndex = 0; PropertyIndex < InProperties.Num(); PropertyIndex++)
 		{
-			const FGMPPropertyInfo& PropInfo = Properties[PropertyIndex];
-			if (!(PropInfo.Property->IsA(FArrayProperty::StaticClass()) && PropertyIndex != Properties.Num() - 1))
+			const FGMPPropertyInfo& PropInfo = InProperties[PropertyIndex];
+			if (!(PropInfo.Property->IsA(FArrayProperty::StaticClass()) && PropertyIndex != InProperties.Num() - 1))
 			{
 				if (!FirstAddition)
 				{
-					NewDisplayName += Separator;
+					Builder.Append(Separator);
 				}
 
-				NewDisplayName += PropInfo.Property->GetFName().ToString();
+				PropInfo.Property->GetFName().AppendString(Builder);
 
 				if (PropInfo.ArrayIndex != INDEX_NONE)
 				{
-					NewDisplayName += FString::Printf(TEXT("[%d]"), PropInfo.ArrayIndex);
+					Builder.Appendf(TEXT("[%d]"), PropInfo.ArrayIndex);
 				}
 
 				FirstAddition = false;
 			}
 		}
+	}
+	void AppendString(FStringBuilderBase& Builder, const TCHAR* Separator = TEXT("->")) const { AppendString(Builder, Properties, Separator); }
 
-		return NewDisplayName;
+	FString ToString(const TCHAR* Separator = TEXT("->")) const
+	{
+		TStringBuilder<256> Builder;
+		AppendString(Builder, Separator);
+		return FString(Builder.ToString());
 	}
 
 	/**
@@ -166,10 +337,162 @@ public:
 		return Result;
 	}
 
+	FGMPCompiledPropertyPath Compile() const { return FGMPCompiledPropertyPath::Compile(Properties); }
+
 private:
 	TArray<FGMPPropertyInfo> Properties;
 };
 
+inline FGMPCompiledPropertyPath FGMPCompiledPropertyPath::Compile(TArrayView<const FGMPPropertyInfo> Path)
+{
+	FGMPCompiledPropertyPath Ret;
+	if (!Path.Num())
+		return Ret;
+
+	const FProperty* Prev = nullptr;
+	for (int32 Idx = 0; Idx < Path.Num(); ++Idx)
+	{
+		const FGMPPropertyInfo& Info = Path[Idx];
+		const FProperty* Prop = Info.Property.Get();
+		if (!Prop)
+			return FGMPCompiledPropertyPath();
+		Ret.WeakProps.Add(const_cast<FProperty*>(Prop));
+
+		auto PrevArray = CastField<FArrayProperty>(Prev);
+		if (PrevArray && PrevArray->Inner == Prop)
+		{
+			// element of the dynamic array the previous step points at
+			if (Info.ArrayIndex == INDEX_NONE)
+				return FGMPCompiledPropertyPath();
+			Ret.Steps.Add(FStep{EStepKind::ArrayElement, 0, GetPropElementSize(Prop), Info.ArrayIndex, nullptr, nullptr});
+		}
+		else
+		{
+			if (Prev && (Prev->IsA<FSetProperty>() || Prev->IsA<FMapProperty>()))
+			{
+				// hashed containers have no stable element offsets
+				return FGMPCompiledPropertyPath();
+			}
+			else if (Prev)
+			{
+				// members of an object ref are relative to the referenced object
+				auto ObjectProp = CastField<FObjectPropertyBase>(Prev);
+				if (ObjectProp && !ObjectProp->IsA<FObjectProperty>())
+					return FGMPCompiledPropertyPath();
+				if (ObjectProp)
+				{
+					// the referenced object is only known at resolve time, check it owns the member
+					const UClass* OwnerClass = Cast<UClass>(Prop->GetOwnerStruct());
+					if (!OwnerClass)
+						return FGMPCompiledPropertyPath();
+					Ret.Steps.Add(FStep{EStepKind::Object, 0, 0, INDEX_NONE, ObjectProp, OwnerClass});
+					Ret.WeakStructs.Add(OwnerClass);
+				}
+			}
+			else
+			{
+				Ret.RootStruct = Prop->GetOwnerStruct();
+				Ret.RootClass = Cast<UClass>(Ret.RootStruct);
+				Ret.WeakStructs.Add(Ret.RootStruct);
+			}
+			Ret.AddOffset(Prop->GetOffset_ForInternal() + (Info.ArrayIndex != INDEX_NONE ? Info.ArrayIndex * GetPropElementSize(Prop) : 0));
+		}
+		Prev = Prop;
+	}
+
+	Ret.LeafProp = Prev;
+	Ret.LeafSize = GetPropElementSize(Prev);
+	Ret.bLeafPlainOldData = Prev->HasAnyPropertyFlags(CPF_IsPlainOldData);
+	return Ret;
+}
+
+// a path segment living on the stack, children point at their parent so recursive walks never copy the prefix
+struct FGMPPropertyPathNode
+{
+	FGMPPropertyPathNode(const FGMPPropertyInfo& InLeaf, const FGMPPropertyPathNode* InParent = nullptr)
+		: Parent(InParent)
+		, Leaf(InLeaf)
+		, Depth(InParent ? InParent->Depth + 1 : 1)
+		, Hash(HashCombine(InParent ? InParent->Hash : 0, InLeaf.GetHash()))
+	{
+	}
+
+	const FGMPPropertyPathNode* Parent;
+	FGMPPropertyInfo Leaf;
+	int32 Depth;
+	uint32 Hash;
+};
+
+// value type path, short paths live inline so building, extending and trimming do not allocate
+class FGMPInlinePropertyPath
+{
+public:
+	static constexpr int32 NumInline = 8;
+
+	FGMPInlinePropertyPath() = default;
+	explicit FGMPInlinePropertyPath(TArrayView<const FGMPPropertyInfo> InProperties)
+		: Properties(InProperties.GetData(), InProperties.Num())
+	{
+		Rehash();
+	}
+	explicit FGMPInlinePropertyPath(const FGMPPropertyPath& Path)
+		: FGMPInlinePropertyPath(Path.GetProperties())
+	{
+	}
+	explicit FGMPInlinePropertyPath(const FGMPPropertyPathNode& Node)
+	{
+		Properties.SetNum(Node.Depth);
+		for (const FGMPPropertyPathNode* It = &Node; It; It = It->Parent)
+			Properties[It->Depth - 1] = It->Leaf;
+		Hash = Node.Hash;
+	}
+
+	int32 GetNumProperties() const { return Properties.Num(); }
+	TArrayView<const FGMPPropertyInfo> GetProperties() const { return Properties; }
+	const FGMPPropertyInfo& GetPropertyInfo(int32 Index) const { return Properties[Index]; }
+	const FGMPPropertyInfo& GetLeafMostProperty() const { return Properties.Last(); }
+	const FGMPPropertyInfo& GetRootProperty() const { return Properties[0]; }
+
+	void AddProperty(const FGMPPropertyInfo& InProperty)
+	{
+		Properties.Add(InProperty);
+		Hash = HashCombine(Hash, InProperty.GetHash());
+	}
+	FGMPInlinePropertyPath ExtendPath(const FGMPPropertyInfo& NewLeaf) const
+	{
+		FGMPInlinePropertyPath NewPath = *this;
+		NewPath.AddProperty(NewLeaf);
+		return NewPath;
+	}
+	FGMPInlinePropertyPath TrimPath(int32 AmountToTrim) const { return FGMPInlinePropertyPath(GetProperties().LeftChop(AmountToTrim)); }
+	FGMPInlinePropertyPath TrimRoot(int32 AmountToTrim) const { return FGMPInlinePropertyPath(GetProperties().RightChop(AmountToTrim)); }
+
+	void AppendString(FStringBuilderBase& Builder, const TCHAR* Separator = TEXT("->")) const { FGMPPropertyPath::AppendString(Builder, Properties, Separator); }
+	FString ToString(const TCHAR* Separator = TEXT("->")) const
+	{
+		TStringBuilder<256> Builder;
+		AppendString(Builder, Separator);
+		return FString(Builder.ToString());
+	}
+
+	FGMPCompiledPropertyPath Compile() const { return FGMPCompiledPropertyPath::Compile(Properties); }
+
+	bool operator==(const FGMPInlinePropertyPath& Other) const { return Hash == Other.Hash && Properties == Other.Properties; }
+	bool operator!=(const FGMPInlinePropertyPath& Other) const { return !(*this == Other); }
+	friend uint32 GetTypeHash(const FGMPInlinePropertyPath& Path) { return Path.Hash; }
+
+private:
+	void Rehash()
+	{
+		Hash = 0;
+		for (const FGMPPropertyInfo& Info : Properties)
+			Hash = HashCombine(Hash, Info.GetHash());
+	}
+
+	TArray<FGMPPropertyInfo, TInlineAllocator<NumInline>> Properties;
+	uint32 Hash = 0;
+};
+
 FORCEINLINE bool operator==(const FGMPPropertyPath& LHS, const FGMPPropertyPath& RHS)
 {
 	if (LHS.GetNumProperties() != RHS.GetNumProperties())
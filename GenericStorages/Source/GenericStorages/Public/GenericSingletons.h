@@ -26,6 +26,18 @@ GENERICSTORAGES_API void CallOnEngineInitCompletedImpl(FSimpleDelegate& Lambda);
 
 GENERICSTORAGES_API bool DelayExec(const UObject* InObj, FTimerDelegate InDelegate, float InDelay = 0.f, bool bEnsureExec = true);
 
+enum class EDelayExecLane : uint8
+{
+	High,
+	Normal,
+	Low,
+	Num,
+};
+// next tick callbacks of a game world are coalesced into one dispatch per frame, lane by lane
+GENERICSTORAGES_API bool CallOnWorldNextTickImpl(const UObject* InObj, FTimerDelegate InDelegate, EDelayExecLane Lane = EDelayExecLane::Normal, bool bEnsureExec = true);
+// BudgetMs <= 0 means unlimited, otherwise callbacks left over are spilled to the next frame
+GENERICSTORAGES_API void SetNextTickBudget(const UObject* InObj, float BudgetMs);
+
 #if WITH_EDITOR
 GENERICSTORAGES_API void CallOnEditorMapOpendImpl(TDelegate<void(UWorld*)> Delegate);
 #endif
@@ -74,10 +86,26 @@ auto CallOnWorldNextTick(const UObject* InObj, F&& Lambda, bool bEnsureExec = tr
 	return DelayExec(InObj, Forward<F>(Lambda), 0.f, bEnsureExec);
 }
 
+template<typename F>
+auto CallOnWorldNextTick(const UObject* InObj, F&& Lambda, GenericStorages::EDelayExecLane Lane, bool bEnsureExec = true)
+{
+	if (InObj)
+		return GenericStorages::CallOnWorldNextTickImpl(InObj, FTimerDelegate::CreateWeakLambda(const_cast<UObject*>(InObj), Forward<F>(Lambda)), Lane, bEnsureExec);
+	else
+		return GenericStorages::CallOnWorldNextTickImpl(InObj, FTimerDelegate::CreateLambda(Forward<F>(Lambda)), Lane, bEnsureExec);
+}
+
 namespace GenericSingletons
 {
 GENERICSTORAGES_API UObject* DynamicReflectionImpl(const FString& TypeName, UClass* TypeClass = nullptr);
+// OutResults keeps the order of TypeNames, unresolved names are nullptr
+GENERICSTORAGES_API int32 DynamicReflectionBatchImpl(TArrayView<const FString> TypeNames, UClass* TypeClass, TArray<UObject*>& OutResults);
+GENERICSTORAGES_API void GetDynamicReflectionStats(uint64& OutHits, uint64& OutMisses);
+GENERICSTORAGES_API void ResetDynamicReflectionCache();
+// handlers are keyed by Desc and the bound object, registering the same pair again replaces the previous handler
 GENERICSTORAGES_API void DeferredWorldCleanup(FSimpleDelegate Cb, FString Desc, bool bEditorOnly = false);
+// a null InObj removes every handler registered with Desc
+GENERICSTORAGES_API bool UnregisterDeferredWorldCleanup(const FString& Desc, const UObject* InObj = nullptr);
 template<typename F>
 void DeferredWorldCleanup(const TCHAR* Desc, F&& f, bool bEditorOnly = false)
 {
@@ -99,6 +127,14 @@ FORCEINLINE T* DynamicReflection(const FString& TypeName)
 	return static_cast<T*>(GenericSingletons::DynamicReflectionImpl(TypeName, T::StaticClass()));
 }
 
+template<typename T = UStruct>
+TArray<T*> DynamicReflections(TArrayView<const FString> TypeNames)
+{
+	TArray<UObject*> Results;
+	GenericSingletons::DynamicReflectionBatchImpl(TypeNames, T::StaticClass(), Results);
+	return MoveTemp(reinterpret_cast<TArray<T*>&>(Results));
+}
+
 FORCEINLINE UScriptStruct* DynamicStruct(const FString& StructName)
 {
 	return DynamicReflection<UScriptStruct>(StructName);
@@ -337,6 +373,14 @@ public:
 		return AsyncLoadCls(InPath, ContextObj, [ContextObj, Cb{MoveTemp(Cb)}](UClass* ResolvedCls) { Cb(CreateInstance<T>(ContextObj, ResolvedCls)); }).IsValid();
 	}
 
+	// load all classes with one request, then create singletons in dependency order ('SingletonDependsOn' meta) within FrameBudgetMs per frame
+	static TSharedPtr<struct FStreamableHandle> PrewarmSingletons(const TArray<FSoftClassPath>& InPaths, const UObject* Ctx, FAsyncBatchObjCallback OnCompleted = {}, float FrameBudgetMs = 2.f, TAsyncLoadPriority Priority = 0);
+	template<typename LambdaType>
+	static FORCEINLINE auto PrewarmSingletons(const TArray<FSoftClassPath>& InPaths, const UObject* Ctx, LambdaType&& OnCompleted, float FrameBudgetMs = 2.f, TAsyncLoadPriority Priority = 0)
+	{
+		return PrewarmSingletons(InPaths, Ctx, CreateWeakLambda<FAsyncBatchObjCallback>(Ctx, Forward<LambdaType>(OnCompleted)), FrameBudgetMs, Priority);
+	}
+
 public:
 	template<typename T>
 	static FString GetTypedNameSafe(const T* Obj = nullptr)
@@ -21,36 +21,54 @@ public:
 };
 
 //////////////////////////////////////////////////////////////////////////
-struct GENERICSTORAGES_API FWeakMemberData
+namespace MemberDataRegistry
+{
+// registered member of one type, cleared when the owner is destroyed
+struct FMemberDataSlot
 {
-protected:
-	TWeakObjectPtr<UObject> Obj;
 	void* Ptr = nullptr;
+	int32 OwnerIndex = INDEX_NONE;
+	int32 OwnerSerial = 0;
 #if WITH_EDITOR
+	FWeakObjectPtr Owner;
 	FStructProperty* Prop = nullptr;
 #endif
-	bool IsValid() const { return (Obj.IsValid() && Ptr); }
 };
 
+// per world table directly addressed by slot id
+struct FMemberDataTable
+{
+	TArray<FMemberDataSlot> Slots;
+
+	FORCEINLINE void* Find(int32 SlotId) const { return SlotId < Slots.Num() ? Slots.GetData()[SlotId].Ptr : nullptr; }
+};
+
+// slot ids are keyed by type name so every module agrees on them
+GENERICSTORAGES_API int32 AllocateSlot(const char* TypeName);
+GENERICSTORAGES_API FMemberDataTable* FindTable(const UObject* WorldContextObj);
+// game thread only, creates the table on demand
+// the reference stays valid until the world is cleaned up, so callers could resolve it once and keep it
+GENERICSTORAGES_API FMemberDataTable& GetTable(const UObject* WorldContextObj);
+GENERICSTORAGES_API bool RegisterData(UObject* Owner, int32 SlotId, void* Ptr, FStructProperty* Prop);
+
+template<typename T>
+struct TMemberDataSlot
+{
+	static int32 Get()
+	{
+		static const int32 SlotId = AllocateSlot(ITS::TypeStr<T>());
+		return SlotId;
+	}
+};
+}  // namespace MemberDataRegistry
+
 template<typename T>
-struct TWeakMemberData : public FWeakMemberData
+struct TWeakMemberData
 {
 protected:
 	friend struct FMemberDataRegistry;
 	static_assert(TIsDerivedFrom<T, FWeakMemberDataTag>::IsDerived, "err");
 
-	T* GetMemberPtr() const
-	{
-#if WITH_EDITOR
-		checkSlow(!Prop || (Prop->Struct && Prop->Struct->IsA<T>()));
-		auto Ret = ensure(FWeakMemberData::IsValid()) ? Prop->ContainerPtrToValuePtr<T>(Obj.Get()) : nullptr;
-		ensure(!Ret || Ret == Ptr);
-		return Ret;
-#else
-		return IsValid() ? reinterpret_cast<T*>(Ptr) : nullptr;
-#endif
-	}
-
 #if WITH_EDITOR
 	template<typename C>
 	static FStructProperty* FindStructProperty(FName PropName)
@@ -61,7 +79,11 @@ protected:
 	}
 #endif
 
-	static T* GetStorage(const UObject* WorldContextObj) { return WorldLocalStorages::GetLocalValue<TWeakMemberData<T>>(WorldContextObj, false); }
+	static T* GetStorage(const UObject* WorldContextObj)
+	{
+		auto Table = MemberDataRegistry::FindTable(WorldContextObj);
+		return Table ? reinterpret_cast<T*>(Table->Find(MemberDataRegistry::TMemberDataSlot<T>::Get())) : nullptr;
+	}
 
 	static T& GetStorage(T& Default, const UObject* WorldContextObj)
 	{
@@ -69,27 +91,27 @@ protected:
 		return Data ? *Data : Default;
 	}
 
+	FORCEINLINE static T* GetStorage(const MemberDataRegistry::FMemberDataTable& Table) { return reinterpret_cast<T*>(Table.Find(MemberDataRegistry::TMemberDataSlot<T>::Get())); }
+
 	template<typename C, std::enable_if_t<std::is_base_of<UObject, std::decay_t<C>>::value>* = nullptr>
 	static bool RegisterStorage(C* This, T(C::*Data), FName DataName)
 	{
+		FStructProperty* Prop = nullptr;
 #if WITH_EDITOR
 		static FName TypeMemberName = DataName;
 		ensure(TypeMemberName == DataName);
-		static auto Prop = TWeakMemberData<T>::template FindStructProperty<C>(DataName);
+		static auto StaticProp = TWeakMemberData<T>::template FindStructProperty<C>(DataName);
+		Prop = StaticProp;
 		check(This && Prop);
 		checkSlow(T::StaticStruct() == Prop->Struct);
 		checkSlow(C::StaticClass() == Prop->GetOuter());
 #endif
 		if (!This->HasAnyFlags(RF_ClassDefaultObject | RF_ArchetypeObject) && ensure(C::StaticClass() == This->GetClass()))
 		{
-			auto& WeakStore = WorldLocalStorages::GetLocalValue<TWeakMemberData<T>>(This);
-			WeakStore.Obj = This;
-			WeakStore.Ptr = &(This->*Data);
 #if WITH_EDITOR
-			WeakStore.Prop = Prop;
-			ensureAlways(WeakStore.GetMemberPtr()->GetOuter() == This);
+			ensureAlways((This->*Data).GetOuter() == This);
 #endif
-			return true;
+			return MemberDataRegistry::RegisterData(This, MemberDataRegistry::TMemberDataSlot<T>::Get(), &(This->*Data), Prop);
 		}
 		return false;
 	}
@@ -109,6 +131,13 @@ struct FMemberDataRegistry
 		return TWeakMemberData<T>::GetStorage(Default, WorldContextObj);
 	}
 
+	// for hot paths, with a table from MemberDataRegistry::GetTable
+	template<typename T>
+	FORCEINLINE static T* GetStorage(const MemberDataRegistry::FMemberDataTable& Table)
+	{
+		return TWeakMemberData<T>::GetStorage(Table);
+	}
+
 	template<typename C, typename T>
 	static bool RegisterStorage(C* This, T(C::*Data), FName DataName)
 	{
@@ -6,40 +6,73 @@
 
 #include "UObject/Object.h"
 
+#include <type_traits>
+
 #include "ObjectDataRegistry.generated.h"
 
 namespace ObjectDataRegistry
 {
+// type-erased operations, stored once per data type
+struct FDataTypeOps
+{
+	int32 Size;
+	int32 Alignment;
+	void (*Destruct)(void*);
+};
+
 template<typename T>
-struct TObjectDataTypeName
+struct TObjectDataTypeOps
+{
+	using DT = typename TDecay<T>::Type;
+	static void DestructImpl(void* Ptr) { static_cast<DT*>(Ptr)->~DT(); }
+	static const FDataTypeOps& GetOps()
+	{
+		static const FDataTypeOps Ops{
+			(int32)sizeof(DT),
+			(int32)alignof(DT),
+			std::is_trivially_destructible<DT>::value ? nullptr : &DestructImpl,
+		};
+		return Ops;
+	}
+};
+
+template<typename T>
+struct TObjectDataTypeName : public TObjectDataTypeOps<T>
 {
 	static auto GetFName() { return T::StaticStruct()->GetFName(); }
-	template<typename... TArgs>
-	static TSharedPtr<void> Create(TArgs&&... Args)
+};
+
+// returns a dense slot id, the same key always maps to the same slot
+GENERICSTORAGES_API int32 RegisterDataType(FName Key, const FDataTypeOps& Ops);
+
+template<typename T>
+struct TObjectDataSlot
+{
+	static int32 Get()
 	{
-		using DT = TDecay<T>;
-		return TSharedPtr<void>(new DT(Forward<TArgs>(Args)...), [](void* Ptr) { delete static_cast<DT*>(Ptr); });
+		static const int32 SlotId = RegisterDataType(TObjectDataTypeName<T>::GetFName(), TObjectDataTypeName<T>::GetOps());
+		return SlotId;
 	}
 };
 }  // namespace ObjectDataRegistry
 
-#define OBJECT_DATA_DEF(T)                                                                                                 \
-	namespace ObjectDataRegistry                                                                                           \
-	{                                                                                                                      \
-		template<>                                                                                                         \
-		struct TObjectDataTypeName<T>                                                                                      \
-		{                                                                                                                  \
-			static auto GetFName() { return TEXT(#T); }                                                                    \
-			template<typename... TArgs>                                                                                    \
-			static TSharedPtr<void> Create(TArgs&&... Args)                                                                \
-			{                                                                                                              \
-				using DT = TDecay<T>;                                                                                      \
-				return TSharedPtr<void>(new DT(Forward<TArgs>(Args)...), [](void* Ptr) { delete static_cast<DT*>(Ptr); }); \
-			}                                                                                                              \
-		};                                                                                                                 \
+// slots of types declared here are assigned during static initialization
+#define OBJECT_DATA_DEF(T)                                                                                         \
+	namespace ObjectDataRegistry                                                                                   \
+	{                                                                                                              \
+		template<>                                                                                                 \
+		struct TObjectDataTypeName<T> : public TObjectDataTypeOps<T>                                               \
+		{                                                                                                          \
+			static auto GetFName() { return TEXT(#T); }                                                            \
+		};                                                                                                         \
+		namespace                                                                                                  \
+		{                                                                                                          \
+			static const int32 PREPROCESSOR_JOIN(ObjectDataSlotRegistrar_, __COUNTER__) = TObjectDataSlot<T>::Get(); \
+		}                                                                                                          \
 	}
 
 // currently it does not support the object refs in ustruct. use weakobjectptr instead!
+// data of each type is stored contiguously in stable chunks, pointers stay valid until the data is removed
 struct FObjectDataRegistry
 {
 public:
@@ -47,26 +80,47 @@ public:
 	static T* FindStorageData(const UObject* Obj)
 	{
 		check(IsValid(Obj));
-		return (T*)FindDataPtr(Obj, ObjectDataRegistry::TObjectDataTypeName<T>::GetFName());
+		return static_cast<T*>(FindSlotPtr(Obj, ObjectDataRegistry::TObjectDataSlot<T>::Get()));
 	}
 
 	template<typename T, typename... TArgs>
 	static T* GetStorageData(const UObject* Obj, TArgs&&... Args)
 	{
 		check(IsValid(Obj));
-		return (T*)GetDataPtr(Obj, ObjectDataRegistry::TObjectDataTypeName<T>::GetFName(), ObjectDataRegistry::TObjectDataTypeName<T>::Create(Forward<TArgs>(Args)...));
+		using DT = typename ObjectDataRegistry::TObjectDataTypeOps<T>::DT;
+		return static_cast<T*>(GetSlotPtr(Obj, ObjectDataRegistry::TObjectDataSlot<T>::Get(), [&](void* Ptr) { new (Ptr) DT(Forward<TArgs>(Args)...); }));
 	}
 
 	template<typename T>
 	static bool RemoveStorageData(UObject* Obj)
 	{
 		check(IsValid(Obj));
-		return DelDataPtr(Obj, ObjectDataRegistry::TObjectDataTypeName<T>::GetFName());
+		return DelSlotPtr(Obj, ObjectDataRegistry::TObjectDataSlot<T>::Get());
+	}
+
+	// Fn(UObject*, T&), game thread only, data may be added but not removed during the iteration
+	template<typename T, typename F>
+	static void ForEachObjectWithData(const F& Fn)
+	{
+		ForEachSlot(ObjectDataRegistry::TObjectDataSlot<T>::Get(), [&](UObject* Obj, void* Ptr) { Fn(Obj, *static_cast<T*>(Ptr)); }, false);
+	}
+
+	// Fn(UObject*, T&) runs on worker threads, the registry must not be modified meanwhile
+	template<typename T, typename F>
+	static void ParallelForEachObjectWithData(const F& Fn)
+	{
+		ForEachSlot(ObjectDataRegistry::TObjectDataSlot<T>::Get(), [&](UObject* Obj, void* Ptr) { Fn(Obj, *static_cast<T*>(Ptr)); }, true);
 	}
 
 protected:
 	friend class UObjectDataRegistryHelper;
-	GENERICSTORAGES_API static void* GetDataPtr(const UObject* Obj, FName Key, const TFunctionRef<TSharedPtr<void>()>& Func);
+	// typed accessors go through slot ids, no name lookup involved
+	GENERICSTORAGES_API static void* GetSlotPtr(const UObject* Obj, int32 SlotId, const TFunctionRef<void(void*)>& Construct);
+	GENERICSTORAGES_API static void* FindSlotPtr(const UObject* Obj, int32 SlotId);
+	GENERICSTORAGES_API static bool DelSlotPtr(const UObject* Obj, int32 SlotId);
+	GENERICSTORAGES_API static void ForEachSlot(int32 SlotId, const TFunctionRef<void(UObject*, void*)>& Fn, bool bParallel);
+
+	GENERICSTORAGES_API static void* GetDataPtr(const UObject* Obj, FName Key, const ObjectDataRegistry::FDataTypeOps& Ops, const TFunctionRef<void(void*)>& Construct);
 	GENERICSTORAGES_API static void* FindDataPtr(const UObject* Obj, FName Key);
 	GENERICSTORAGES_API static bool DelDataPtr(const UObject* Obj, FName Key);
 };
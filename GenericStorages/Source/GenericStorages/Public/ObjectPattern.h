@@ -4,13 +4,18 @@
 
 #include "CoreMinimal.h"
 
+#include "Async/ParallelFor.h"
 #include "Engine/EngineTypes.h"
+#include "Misc/ScopeRWLock.h"
 #include "Templates/SubclassOf.h"
+#include "UObject/ObjectKey.h"
 
 #include "ObjectPattern.generated.h"
 
 template<typename T>
 struct TEachObjectPattern;
+template<typename T>
+struct TDenseObjectPattern;
 
 USTRUCT()
 struct GENERICSTORAGES_API FObjectPatternType
@@ -18,19 +23,40 @@ struct GENERICSTORAGES_API FObjectPatternType
 	GENERATED_BODY()
 public:
 	using FWeakObjectArray = TArray<FWeakObjectPtr>;
-	TSharedPtr<FWeakObjectArray> Objects;
-	bool IsValid() const { return Objects.IsValid(); }
-	UObject* FirstObject() const
+	using FSnapshotPtr = TSharedPtr<const FWeakObjectArray, ESPMode::ThreadSafe>;
+	struct FPartition
 	{
-		check(IsValid());
-		return Objects->Num() > 0 ? (*Objects)[0].Get() : nullptr;
-	}
+		// owning world, null for objects whose world is not known yet
+		FObjectKey World;
+		FWeakObjectArray Objects;
+		// immutable copy shared by readers, rebuilt on demand after writes
+		FSnapshotPtr Snapshot;
+	};
+	struct FRegistry
+	{
+		TArray<FPartition, TInlineAllocator<2>> Partitions;
+		FSnapshotPtr AllSnapshot;
+	};
+	TSharedPtr<FRegistry> Objects;
+	bool IsValid() const { return Objects.IsValid(); }
+	UObject* FirstObject() const;
+
+	// writers and GetSnapshot require UObjectPattern::Critical
+	void Add(UObject* Obj, const UWorld* World);
+	void Remove(UObject* Obj);
+	int32 Find(UObject* Obj) const;
 
-	void Add(UObject* Obj) { Objects->Add(Obj); }
-	void Remove(UObject* Obj) { Objects->Remove(Obj); }
-	auto Find(UObject* Obj) { return Objects->Find(FWeakObjectPtr(Obj)); }
+	// null world returns the objects of all worlds
+	FSnapshotPtr GetSnapshot(const UWorld* World);
+	int32 Compact();
+	// moves the objects of the pending partition which now belong to World
+	void ResolvePending(const UWorld* World);
+	void RemoveWorld(const UWorld* World);
+	void CollectSizes(TMap<FObjectKey, int32>& InOutSizes) const;
 
-	FWeakObjectArray::TIterator CreateIterator();
+protected:
+	FPartition& FindOrAddPartition(FObjectKey World);
+	void ResetSnapshots();
 };
 
 //////////////////////////////////////////////////////////////////////////
@@ -55,6 +81,60 @@ public:
 
 	static void EachObject(const UObject* WorldContextObj, UClass* Class, const TFunctionRef<void(UObject*)>& f);
 
+	// maintenance step, drops stale entries which are skipped but kept by iterations
+	// and moves objects whose world was unknown at registration into their world partition
+	static void CompactRegistries();
+
+	// logs per world registry sizes
+	static void DumpRegistries(FOutputDevice& Ar);
+
+	// Fn(T*) runs on task graph workers in chunks of at least MinBatch entries, it must not mutate shared state
+	// dense types walk the process wide dense array filtered by world, others the world partition of WorldContextObj
+	template<typename T, typename F>
+	static void ParallelEachObject(const UObject* WorldContextObj, const F& Fn, int32 MinBatch = 256)
+	{
+		struct FNoContext
+		{
+		};
+		TArray<FNoContext> Contexts;
+		ParallelEachObjectWithContext<T>(WorldContextObj, Contexts, [&](FNoContext&, T* Obj) { Fn(Obj); }, MinBatch);
+	}
+	// Fn(TContext&, T*), OutContexts holds one accumulator per chunk which are merged by the caller afterwards
+	template<typename T, typename TContext, typename F>
+	static void ParallelEachObjectWithContext(const UObject* WorldContextObj, TArray<TContext>& OutContexts, const F& Fn, int32 MinBatch = 256);
+
+	// process wide linear walk over TDenseObjectPattern<T> instances, dense readers share the lock
+	// entries are removed on destruction, objects marked as garbage are still visited
+	template<typename T, typename F>
+	static void EachDenseObject(const F& f)
+	{
+		ReadDenseObjects<T>([&](TArrayView<T* const> Objects) {
+			for (T* Obj : Objects)
+				f(Obj);
+		});
+	}
+	// f(TArrayView<T* const>), the view must not escape f
+	// f runs on a copy taken under the lock, so it may spawn or destroy dense objects
+	template<typename T, typename F>
+	static void ReadDenseObjects(const F& f)
+	{
+		static_assert(TIsDerivedFrom<T, TDenseObjectPattern<T>>::IsDerived, "err");
+		FDenseRegistry& Registry = GetDenseRegistry<T>();
+		TArray<void*> Objects;
+		{
+			FRWScopeLock ScopeLock(Registry.Lock, SLT_ReadOnly);
+			Objects = Registry.Objects;
+		}
+		f(TArrayView<T* const>(reinterpret_cast<T* const*>(Objects.GetData()), Objects.Num()));
+	}
+	template<typename T>
+	static int32 NumDenseObjects()
+	{
+		FDenseRegistry& Registry = GetDenseRegistry<T>();
+		FRWScopeLock ScopeLock(Registry.Lock, SLT_ReadOnly);
+		return Registry.Objects.Num();
+	}
+
 	DECLARE_DYNAMIC_DELEGATE_OneParam(FOnEachObjectAction, UObject*, Obj);
 	UFUNCTION(BlueprintCallable, BlueprintInternalUseOnly, Category = "Game", meta = (NeuronAction, DisplayName = "EachObject", WorldContext = "WorldContextObj", HidePin = "WorldContextObj"))
 	static void EachObject(const UObject* WorldContextObj, UClass* Class, UPARAM(meta = (DeterminesOutputType = "Class", DynamicOutputParam = "Obj")) FOnEachObjectAction OnEachObj)
@@ -135,15 +215,16 @@ protected:
 	static int32 GetTypeID(UClass* Class);
 
 	template<typename T>
-	static auto NativeIterator()
+	static auto NativeSnapshot(const UObject* WorldContextObj)
 	{
 		auto Index = GetTypeID<T>();
 		static_assert(TIsDerivedFrom<T, TEachObjectPattern<T>>::IsDerived, "err");
 		static_assert(TIsDerivedFrom<T, UObject>::IsDerived && !std::is_same<T, UObject>::value, "err");
 		check(Index);
-		return NativeIterator(Index);
+		return NativeSnapshot(Index, WorldContextObj);
 	}
-	static FObjectPatternType::FWeakObjectArray::TIterator NativeIterator(int32 Index);
+	static FObjectPatternType::FSnapshotPtr NativeSnapshot(int32 Index, const UObject* WorldContextObj);
+	static FObjectPatternType::FSnapshotPtr ClassSnapshot(const UObject* WorldContextObj, UClass* Class);
 
 	//////////////////////////////////////////////////////////////////////////
 	template<typename T>
@@ -199,6 +280,76 @@ protected:
 		}
 	}
 
+	template<typename T, typename ItemType, typename TContext, typename R, typename F>
+	static void ParallelChunks(TArrayView<ItemType> Items, TArray<TContext>& OutContexts, int32 MinBatch, const R& Resolve, const F& Fn)
+	{
+		// keep chunk boundaries on cache lines
+		constexpr int32 ItemsPerLine = PLATFORM_CACHE_LINE_SIZE > sizeof(ItemType) ? PLATFORM_CACHE_LINE_SIZE / sizeof(ItemType) : 1;
+		const int32 BatchSize = FMath::DivideAndRoundUp(FMath::Max(MinBatch, 1), ItemsPerLine) * ItemsPerLine;
+		const int32 NumChunks = FMath::DivideAndRoundUp(Items.Num(), BatchSize);
+		OutContexts.Reset(NumChunks);
+		OutContexts.SetNum(NumChunks);
+		ParallelFor(NumChunks, [&](int32 ChunkIdx) {
+			TContext& Context = OutContexts[ChunkIdx];
+			const int32 End = FMath::Min(Items.Num(), (ChunkIdx + 1) * BatchSize);
+			for (int32 Idx = ChunkIdx * BatchSize; Idx < End; ++Idx)
+			{
+				if (T* Obj = Resolve(Items[Idx]))
+					Fn(Context, Obj);
+			}
+		});
+	}
+
+	// lives in this module so that every module sees the same objects, entries are T* stored as void*
+	struct FDenseRegistry
+	{
+		FRWLock Lock;
+		TArray<void*> Objects;
+	};
+	static FDenseRegistry& GetDenseRegistry(const UClass* Class);
+	template<typename T>
+	static FDenseRegistry& GetDenseRegistry()
+	{
+		// registries are never freed, the reference can be kept per module
+		static FDenseRegistry& Registry = GetDenseRegistry(T::StaticClass());
+		return Registry;
+	}
+
+	template<typename T>
+	friend struct TDenseObjectPattern;
+	template<typename T>
+	static void RegisterDense(T* Obj)
+	{
+		TDenseObjectPattern<T>* Pattern = Obj;
+		check(Pattern->DenseIndex == INDEX_NONE);
+		if (Obj->HasAnyFlags(RF_ClassDefaultObject | RF_ArchetypeObject | RF_DefaultSubObject) || !EditorIsGameWorld(Obj))
+			return;
+#if WITH_EDITOR
+		if (Obj->HasAnyFlags(RF_Transactional))
+			return;
+#endif
+		FDenseRegistry& Registry = GetDenseRegistry<T>();
+		FRWScopeLock ScopeLock(Registry.Lock, SLT_Write);
+		Pattern->DenseIndex = Registry.Objects.Add(Obj);
+	}
+
+	template<typename T>
+	static void UnregisterDense(T* Obj)
+	{
+		TDenseObjectPattern<T>* Pattern = Obj;
+		if (Pattern->DenseIndex == INDEX_NONE)
+			return;
+
+		FDenseRegistry& Registry = GetDenseRegistry<T>();
+		FRWScopeLock ScopeLock(Registry.Lock, SLT_Write);
+		const int32 Index = Pattern->DenseIndex;
+		check(Registry.Objects.IsValidIndex(Index) && Registry.Objects[Index] == static_cast<void*>(Obj));
+		Registry.Objects.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+		if (Registry.Objects.IsValidIndex(Index))
+			static_cast<TDenseObjectPattern<T>*>(static_cast<T*>(Registry.Objects[Index]))->DenseIndex = Index;
+		Pattern->DenseIndex = INDEX_NONE;
+	}
+
 	template<typename T>
 	static void UnsetObject(T* Obj)
 	{
@@ -265,8 +416,6 @@ void UObjectPattern::EachObject(const UObject* WorldContextObj, const F& f)
 	if (!EditorIsGameWorld(WorldContextObj))
 		return;
 
-	FCSLock423 Lock;
-
 #if WITH_EDITOR
 	if (GIsEditor)
 	{
@@ -275,21 +424,47 @@ void UObjectPattern::EachObject(const UObject* WorldContextObj, const F& f)
 	else
 #endif
 	{
-		for (auto It = NativeIterator<T>(); It;)
+		// the lock is only held to fetch the snapshot, stale entries are skipped until CompactRegistries
+		auto Snapshot = NativeSnapshot<T>(WorldContextObj);
+		for (auto& Weak : *Snapshot)
 		{
-			if (auto a = It->Get())
-			{
+			if (auto a = Weak.Get())
 				f(static_cast<T*>(a));
-				++It;
-			}
-			else
-			{
-				It.RemoveCurrent();
-			}
 		}
 	}
 }
 
+template<typename T, typename TContext, typename F>
+void UObjectPattern::ParallelEachObjectWithContext(const UObject* WorldContextObj, TArray<TContext>& OutContexts, const F& Fn, int32 MinBatch)
+{
+	OutContexts.Reset();
+	if (!EditorIsGameWorld(WorldContextObj))
+		return;
+
+	if constexpr (TIsDerivedFrom<T, TDenseObjectPattern<T>>::IsDerived)
+	{
+		// same world filter as the partitioned path, resolved once before dispatch
+		const UWorld* World = WorldContextObj ? WorldContextObj->GetWorld() : nullptr;
+		if (WorldContextObj && !World)
+			return;
+		ReadDenseObjects<T>([&](TArrayView<T* const> Objects) {
+			ParallelChunks<T>(Objects, OutContexts, MinBatch, [World](T* Obj) { return (!World || Obj->GetWorld() == World) ? Obj : nullptr; }, Fn);
+		});
+	}
+	else
+	{
+		FObjectPatternType::FSnapshotPtr Snapshot;
+#if WITH_EDITOR
+		if (GIsEditor)
+			Snapshot = ClassSnapshot(WorldContextObj, T::StaticClass());
+		else
+#endif
+			Snapshot = NativeSnapshot<T>(WorldContextObj);
+
+		ParallelChunks<T>(TArrayView<const FWeakObjectPtr>(*Snapshot), OutContexts, MinBatch, [](const FWeakObjectPtr& Weak) { return static_cast<T*>(Weak.Get()); }, Fn);
+	}
+}
+
 template<typename T>
 int32 UObjectPattern::TypeID;
 template<typename T>
@@ -304,6 +479,27 @@ protected:
 	static auto Dtor(T* This) { return UObjectPattern::Unregister(This); }
 };
 
+// opt-in contiguous T* registry on top of TEachObjectPattern, see UObjectPattern::EachDenseObject
+template<typename T>
+struct TDenseObjectPattern : public TEachObjectPattern<T>
+{
+protected:
+	static auto Ctor(T* This)
+	{
+		TEachObjectPattern<T>::Ctor(This);
+		UObjectPattern::RegisterDense(This);
+	}
+	static auto Dtor(T* This)
+	{
+		UObjectPattern::UnregisterDense(This);
+		TEachObjectPattern<T>::Dtor(This);
+	}
+
+private:
+	friend class UObjectPattern;
+	int32 DenseIndex = INDEX_NONE;
+};
+
 template<typename T>
 struct TSingleObjectPattern
 {
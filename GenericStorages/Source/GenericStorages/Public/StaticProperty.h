@@ -4,6 +4,8 @@
 #include "CoreMinimal.h"
 #include "UnrealCompatibility.h"
 
+#include <atomic>
+
 namespace GenericStorages
 {
 #define PROPERTY_FIND_OR_ADD WITH_EDITOR
@@ -52,6 +54,10 @@ namespace GenericStorages
 		{
 			return VerifyPropertyType(Prop, T::StaticClass());
 		}
+#if PROPERTY_FIND_OR_ADD
+		// bumped on hot reload and blueprint recompile, cached properties are resolved again after that
+		GENERICSTORAGES_API extern std::atomic<uint32> PropertyGeneration;
+#endif
 		GENERICSTORAGES_API const FProperty*& FindOrAddProperty(FName PropTypeName);
 		GENERICSTORAGES_API const FProperty* FindOrAddProperty(FName PropTypeName, const FProperty* Prop);
 		template<typename T>
@@ -296,52 +302,75 @@ namespace GenericStorages
 					Prop->AddCppProperty(const_cast<FProperty*>(ValueProp));
 					return Prop;
 				};
-				return FindOrAddProperty<FMapProperty>(MapPropName);
+				return FindOrAddProperty<FMapProperty>(MapPropName, ConstructProp);
 			}
 		};
 	}
 
-	template<typename TT>
-	const FProperty* StaticProperty()
+	namespace Details
 	{
-		using namespace Details;
-		using T = std::remove_cvref_t<TT>;
-		if constexpr (TModels_V<CStaticStructProvider, T>)
-		{
-			return TSructPropertyTraits<T>::GetProperty();
-		}
-		else if constexpr (std::is_same<std::remove_pointer_t<T>, UClass>::value)
-		{
-			return FObjectPropertyTraits::GetProperty<T, FClassProperty>(UObject::StaticClass()->GetFName());
-		}
-		else if constexpr (TIsDerivedFrom<std::remove_pointer_t<T>, UObject>::Value)
-		{
-			return FObjectPropertyTraits::GetProperty<T, FObjectProperty>();
-		}
-		else if constexpr (TObjectPropertyTraits<T>::value)
-		{
-			return TObjectPropertyTraits<T>::GetProperty();
-		}
-		else if constexpr (TIsEnum<T>::Value)
+		template<typename TT>
+		const FProperty* ResolveStaticProperty()
 		{
-			return TEnumPropertyTraits<T>::GetProperty();
-		}
-		else if constexpr (TIsTArray<T>::Value)
-		{
-			return TArrayPropertyTraits<T>::GetProperty();
-		}
-		else if constexpr (TIsTSet<T>::Value)
-		{
-			return TSetPropertyTraits<T>::GetProperty();
-		}
-		else if constexpr (TIsTMap<T>::Value)
-		{
-			return TMapPropertyTraits<T>::GetProperty();
+			using T = std::remove_cvref_t<TT>;
+			if constexpr (TModels_V<CStaticStructProvider, T>)
+			{
+				return TSructPropertyTraits<T>::GetProperty();
+			}
+			else if constexpr (std::is_same<std::remove_pointer_t<T>, UClass>::value)
+			{
+				return FObjectPropertyTraits::GetProperty<T, FClassProperty>(UObject::StaticClass()->GetFName());
+			}
+			else if constexpr (TIsDerivedFrom<std::remove_pointer_t<T>, UObject>::Value)
+			{
+				return FObjectPropertyTraits::GetProperty<T, FObjectProperty>();
+			}
+			else if constexpr (TObjectPropertyTraits<T>::value)
+			{
+				return TObjectPropertyTraits<T>::GetProperty();
+			}
+			else if constexpr (TIsEnum<T>::Value)
+			{
+				return TEnumPropertyTraits<T>::GetProperty();
+			}
+			else if constexpr (TIsTArray<T>::Value)
+			{
+				return TArrayPropertyTraits<T>::GetProperty();
+			}
+			else if constexpr (TIsTSet<T>::Value)
+			{
+				return TSetPropertyTraits<T>::GetProperty();
+			}
+			else if constexpr (TIsTMap<T>::Value)
+			{
+				return TMapPropertyTraits<T>::GetProperty();
+			}
+			else
+			{
+				return TBasicPropertyTraits<T>::GetProperty();
+			}
 		}
-		else
-		{
-			return TBasicPropertyTraits<T>::GetProperty();
+	}
+
+	// properties are immutable once built, each type keeps its own pointer
+	template<typename TT>
+	const FProperty* StaticProperty()
+	{
+#if PROPERTY_FIND_OR_ADD
+		// any thread may refresh it, the generation is stored last and publishes the pointer
+		static std::atomic<const FProperty*> Cached{nullptr};
+		static std::atomic<uint32> CachedGeneration{0};
+		const uint32 Generation = Details::PropertyGeneration.load(std::memory_order_acquire);
+		if (CachedGeneration.load(std::memory_order_acquire) != Generation)
+		{
+			Cached.store(Details::ResolveStaticProperty<TT>(), std::memory_order_relaxed);
+			CachedGeneration.store(Generation, std::memory_order_release);
 		}
+		return Cached.load(std::memory_order_relaxed);
+#else
+		static const FProperty* Cached = Details::ResolveStaticProperty<TT>();
+		return Cached;
+#endif
 	}
 }
 
@@ -385,11 +414,23 @@ struct FInstancedPropertyVal
 	{
 		return Addr;
 	}
+	void* GetMutableMemory()
+	{
+		return Addr;
+	}
+	const FProperty* GetProperty() const
+	{
+		return Prop;
+	}
+	static FORCEINLINE int32 GetAllocSize(const FProperty* Prop)
+	{
+		return GetPropElementSize(Prop) + sizeof(Prop);
+	}
 protected:
+	friend struct FInstancedPropertyValPool;
 	static FORCEINLINE FInstancedPropertyVal* MakeRaw(const FProperty* Prop, const void* Src = nullptr)
 	{
-		auto Ptr = static_cast<FInstancedPropertyVal*>(FMemory::Malloc(GetPropElementSize(Prop) + sizeof(Prop),
-																		 Prop->GetMinAlignment()));
+		auto Ptr = static_cast<FInstancedPropertyVal*>(FMemory::Malloc(GetAllocSize(Prop), Prop->GetMinAlignment()));
 		new (Ptr) FInstancedPropertyVal(Prop, Src);
 		return Ptr;
 	}